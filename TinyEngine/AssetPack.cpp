@@ -0,0 +1,161 @@
+#include "AssetPack.h"
+
+#include <string.h>
+
+// The mapping code is kept out of the header so windows.h isn't included everywhere.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Whether an entry's description matches its data, so the code using it never reads past
+// the data or hands SDL a format it doesn't understand.
+static bool validEntry(const AssetPackEntry& entry) {
+    if (entry.offset % AssetPack::ALIGNMENT != 0) {
+        return false;
+    }
+    switch (entry.kind) {
+    case PACK_IMAGE: {
+        // The SDL surface calls take ints, and need a packed format they can describe.
+        int bpp = 0;
+        Uint32 red, green, blue, alpha;
+        if (SDL_ISPIXELFORMAT_FOURCC(entry.format) || SDL_BYTESPERPIXEL(entry.format) == 0
+            || !SDL_PixelFormatEnumToMasks(entry.format, &bpp, &red, &green, &blue, &alpha)) {
+            return false;
+        }
+        if (entry.width == 0 || entry.height == 0 || entry.width > SDL_MAX_SINT32 || entry.height > SDL_MAX_SINT32
+            || entry.pitch > SDL_MAX_SINT32) {
+            return false;
+        }
+        return (Uint64) entry.pitch >= (Uint64) entry.width * SDL_BYTESPERPIXEL(entry.format)
+            && (Uint64) entry.pitch * entry.height <= entry.size;
+    }
+    case PACK_PCM: {
+        switch (entry.format) {
+        case AUDIO_U8: case AUDIO_S8: case AUDIO_U16LSB: case AUDIO_S16LSB: case AUDIO_U16MSB: case AUDIO_S16MSB:
+        case AUDIO_S32LSB: case AUDIO_S32MSB: case AUDIO_F32LSB: case AUDIO_F32MSB:
+            break;
+        default:
+            return false;
+        }
+        // Mix_QuickLoad_RAW takes a Uint32 length, and the samples must end on a whole frame.
+        Uint64 frameSize = (Uint64) SDL_AUDIO_BITSIZE(entry.format) / 8 * entry.height;
+        return entry.width > 0 && entry.width <= SDL_MAX_SINT32 && entry.height > 0 && entry.height <= 255
+            && entry.size > 0 && entry.size <= SDL_MAX_UINT32 && entry.size % frameSize == 0;
+    }
+    case PACK_FILE:
+        // SDL_RWFromConstMem takes an int size.
+        return entry.size <= SDL_MAX_SINT32;
+    default:
+        return false;
+    }
+}
+
+bool AssetPack::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        SDL_Log("Could not open asset pack %s", path.c_str());
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(fileHandle, &size);
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* view = mappingHandle != NULL ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    file = fileHandle;
+    mapping = mappingHandle;
+    if (view == NULL) {
+        SDL_Log("Could not map asset pack %s", path.c_str());
+        close();
+        return false;
+    }
+    bytes = static_cast<const Uint8*>(view);
+    length = (size_t) size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SDL_Log("Could not open asset pack %s", path.c_str());
+        return false;
+    }
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        view = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        SDL_Log("Could not map asset pack %s", path.c_str());
+        return false;
+    }
+    bytes = static_cast<const Uint8*>(view);
+    length = (size_t) info.st_size;
+#endif
+
+    if (!readIndex()) {
+        SDL_Log("Asset pack %s is damaged or from another version", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close() {
+    index.clear();
+#ifdef _WIN32
+    if (bytes != NULL) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mapping != NULL) {
+        CloseHandle(mapping);
+    }
+    if (file != NULL) {
+        CloseHandle(file);
+    }
+#else
+    if (bytes != NULL) {
+        munmap(const_cast<Uint8*>(bytes), length);
+    }
+#endif
+    bytes = NULL;
+    length = 0;
+    file = NULL;
+    mapping = NULL;
+}
+
+bool AssetPack::readIndex() {
+    if (length < sizeof(AssetPackHeader)) {
+        return false;
+    }
+    const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(bytes);
+    if (memcmp(header->magic, "TEPK", 4) != 0 || header->version != VERSION) {
+        return false;
+    }
+
+    size_t entriesEnd = sizeof(AssetPackHeader) + (size_t) header->count * sizeof(AssetPackEntry);
+    if (entriesEnd > length || header->namesSize > length - entriesEnd) {
+        return false;
+    }
+    const AssetPackEntry* entries = reinterpret_cast<const AssetPackEntry*>(bytes + sizeof(AssetPackHeader));
+    const char* names = reinterpret_cast<const char*>(bytes + entriesEnd);
+
+    for (Uint32 i = 0; i < header->count; i++) {
+        const AssetPackEntry& entry = entries[i];
+        if ((Uint64) entry.nameOffset + entry.nameLength > header->namesSize
+            || entry.offset > length || entry.size > length - entry.offset || !validEntry(entry)) {
+            return false;
+        }
+        std::string name(names + entry.nameOffset, entry.nameLength);
+        index[std::make_pair(name, entry.kind)] = &entry;
+    }
+    return true;
+}
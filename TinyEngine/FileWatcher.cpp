@@ -0,0 +1,134 @@
+#include "FileWatcher.h"
+
+#include <SDL2/SDL.h>
+
+// inotify is Linux only; other platforms can't hot reload for now.
+#ifdef __linux__
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+bool FileWatcher::watch(const std::string& directory) {
+    if (fd < 0) {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            SDL_Log("Could not start watching files");
+            return false;
+        }
+    }
+
+    std::string path = directory;
+    while (path.size() > 1 && path[path.size() - 1] == '/') {
+        path.erase(path.size() - 1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!addWatches(path)) {
+            SDL_Log("Could not watch %s", directory.c_str());
+            return false;
+        }
+    }
+
+    if (!running) {
+        running = true;
+        thread = std::thread(&FileWatcher::run, this);
+    }
+    return true;
+}
+
+bool FileWatcher::addWatches(const std::string& directory) {
+    int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+    if (wd < 0) {
+        return false;
+    }
+    directories[wd] = directory;
+
+    DIR* dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        return true;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        // Some file systems don't say what an entry is; IN_ONLYDIR skips files then.
+        if (entry->d_type == DT_DIR || entry->d_type == DT_UNKNOWN) {
+            addWatches(directory + "/" + name);
+        }
+    }
+    closedir(dir);
+    return true;
+}
+
+void FileWatcher::run() {
+    alignas(struct inotify_event) char buffer[4096];
+    while (running) {
+        // Wake up now and then to see if we should stop.
+        struct pollfd ready = { fd, POLLIN, 0 };
+        if (poll(&ready, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (char* p = buffer; p < buffer + length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                directories.erase(directory);
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            std::string path = directory->second + "/" + event->name;
+            if (event->mask & IN_ISDIR) {
+                addWatches(path);
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                // Editors either write files in place or move a finished copy over them.
+                changed.insert(path);
+            }
+        }
+    }
+}
+
+void FileWatcher::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+#else
+
+bool FileWatcher::watch(const std::string& directory) {
+    SDL_Log("Could not watch %s: watching files is only supported on Linux", directory.c_str());
+    return false;
+}
+
+bool FileWatcher::addWatches(const std::string&) {
+    return false;
+}
+
+void FileWatcher::run() {
+}
+
+void FileWatcher::stop() {
+}
+
+#endif
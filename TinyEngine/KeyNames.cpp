@@ -0,0 +1,3 @@
+#include "KeyNames.h"
+
+constexpr KeyName KeyNames::TABLE[];
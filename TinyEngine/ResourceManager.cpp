@@ -1,3 +1,5 @@
 #include "ResourceManager.h"
 
-ResourceManager* ResourceManager::inst_ = NULL;
+std::atomic<ResourceManager*> ResourceManager::inst_(NULL);
+std::mutex ResourceManager::instMutex_;
+std::atomic<Uint32> ResourceManager::instances_(0);
@@ -1,3 +1,4 @@
 #include "SFXManager.h"
 
-SFXManager* SFXManager::sfxInstance = NULL;
+std::atomic<SFXManager*> SFXManager::sfxInstance(NULL);
+std::mutex SFXManager::instanceMutex;
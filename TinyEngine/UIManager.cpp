@@ -1,3 +1,4 @@
 #include "UIManager.h"
 
-UIManager* UIManager::uiInstance = NULL;
+std::atomic<UIManager*> UIManager::uiInstance(NULL);
+std::mutex UIManager::instanceMutex;
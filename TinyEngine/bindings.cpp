@@ -16,9 +16,19 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <functional>
 
 #include "SFXManager.h"
 #include "UIManager.h"
+#include "DrawCommandBuffer.h"
+#include "GLRenderer.h"
+#include "FramePacer.h"
+#include "AssetCooker.h"
+#include "InputEvents.h"
+#include "InputLatency.h"
+#include "InputLog.h"
+#include "InputState.h"
+#include "KeyNames.h"
 
 /**
  * TinyEngine API.
@@ -30,7 +40,10 @@ public:
     * Constructs a new SDL graphics program.
     */
     GameEngine(/** desired window width */int w, /** desired window width */int h,
-    /** Desired window title. */ std::string title);
+    /** Desired window title. */ std::string title,
+    /** "sdl" to draw with SDL_Renderer, or "gl" to draw with OpenGL 3.3. */ std::string backend = "sdl",
+    /** Render offscreen without a window, audio device or frame cap. Also enabled by
+        setting the TINYENGINE_HEADLESS environment variable. */ bool headless = false);
 
 
     /**
@@ -39,7 +52,7 @@ public:
     ~GameEngine();
 
     /**
-    * Setup OpenGL.
+    * Setup OpenGL. Returns false if an OpenGL 3.3 context could not be created.
     */
     bool initGL();
 
@@ -63,11 +76,43 @@ public:
     */
     void loop();
 
+    /**
+    * Runs the game until the window is closed or Stop() is called. update is called
+    * with a fixed timestep hz times per second of game time, and render once per
+    * displayed frame with how far (0 to 1) the game has moved towards the next update,
+    * for interpolating positions. clear(), flip() and the frame cap are handled here.
+    */
+    void Run(/** Advances the game by the given number of seconds */ std::function<void(double)> update,
+        /** Draws the game, given the interpolation alpha */ std::function<void(double)> render,
+        /** Updates per second of game time */ int hz,
+        /** Most updates to run in one frame before dropping game time to catch up */ int maxSteps = 5);
+
+    /**
+    * Makes Run() return after the current frame.
+    */
+    void Stop();
+
+    /**
+    * Returns how many updates Run() dropped because the game fell too far behind.
+    */
+    int GetDroppedSteps();
+
     /**
     * Retrieve a pointer to the SDL Window.
     */
     SDL_Window* getSDLWindow();
 
+    /**
+    * Returns whether the engine is running without a window.
+    */
+    bool IsHeadless();
+
+    /**
+    * Turns all drawing on or off. Game logic, input and audio keep working when off,
+    * which is the fastest way to run a game headless.
+    */
+    void SetRenderingEnabled(/** Whether anything should be drawn */ bool enabled);
+
     /**
     * Draws a rectangle whose upper left corner is at the given coordinates,
     * and has the given dimensions. Can be wireframe or filled.
@@ -90,6 +135,33 @@ public:
         /** The upper left y position of the image. */ int y, /** The width of the image. */ int w,
         /** The height of the image. */ int h);
 
+    /**
+    * Draws an image loaded with LoadTexture at the given X,Y position, with the given dimensions.
+    */
+    void DrawImage(/** The handle from LoadTexture. */ int texture,
+        /** The upper left x position of the image. */ int x,
+        /** The upper left y position of the image. */ int y, /** The width of the image. */ int w,
+        /** The height of the image. */ int h);
+
+    /**
+    * Draws many copies of one image with a single SDL_RenderGeometry call, or one
+    * SDL_RenderCopy per copy with SDL versions before 2.0.18.
+    * Each rectangle is either 4 ints (destination x, y, w, h) or 8 ints
+    * (destination followed by the source x, y, w, h within the image).
+    */
+    void DrawImageBatch(/** The filepath. */ std::string imgPath,
+        /** The packed rectangles. */ const int* rects,
+        /** The number of rectangles. */ int count,
+        /** The number of ints per rectangle, either 4 or 8. */ int stride);
+
+    /**
+    * Draws many copies of an image loaded with LoadTexture, as DrawImageBatch does.
+    */
+    void DrawImageBatch(/** The handle from LoadTexture. */ int texture,
+        /** The packed rectangles. */ const int* rects,
+        /** The number of rectangles. */ int count,
+        /** The number of ints per rectangle, either 4 or 8. */ int stride);
+
     /**
     * Draws a frame of a sprite sheet.
     */
@@ -102,6 +174,17 @@ public:
         /** Width of 1 frame in the spritesheet. */ int frameWidth,
         /** Height of 1 frame in the spritesheet. */ int frameHeight);
 
+    /**
+    * Draws a frame of a sprite sheet loaded with LoadTexture.
+    */
+    void DrawFrame(/** The handle from LoadTexture. */ int texture,
+        /** The "tick" number in the current second. */ int frameTick,
+        /** The total number of frames. */int spriteNumFrames,
+        /** The upper left x position of the image. */ int x,
+        /** The upper left y position of the image. */ int y,
+        /** Width of 1 frame in the spritesheet. */ int frameWidth,
+        /** Height of 1 frame in the spritesheet. */ int frameHeight);
+
     /**
     * Plays music (on loop) from the given file.
     */
@@ -117,6 +200,28 @@ public:
     */
     void PlaySFX(/** The filepath of the sound effect file */ std::string path);
 
+    /**
+    * Plays a sound effect loaded with LoadSound.
+    */
+    void PlaySFX(/** The handle from LoadSound */ int sound);
+
+    /**
+    * Loads an image and returns a handle for drawing it, or -1 if it could not be loaded.
+    * Drawing by handle skips looking the image up by path every call.
+    */
+    int LoadTexture(/** The filepath of the image */ std::string path);
+
+    /**
+    * Loads a sound effect and returns a handle for playing it, or -1 if it could not be loaded.
+    */
+    int LoadSound(/** The filepath of the sound effect file */ std::string path);
+
+    /**
+    * Loads a font at the given size and returns a handle for rendering text with it,
+    * or -1 if it could not be loaded.
+    */
+    int LoadFont(/** The filepath of the .ttf file */ std::string path, /** The font size */ int size);
+
     /**
     * Set the music volume from 0 to 128.
     */
@@ -135,6 +240,12 @@ public:
         /** The font size to render at */ int fontSize, /** left hand x position of text */ int x,
         /** Upper y position of text */ int y);
 
+    /**
+    * Renders the given text in a font loaded with LoadFont.
+    */
+    void RenderText(/** Text to render */ std::string text, /** The handle from LoadFont */ int font,
+        /** left hand x position of text */ int x, /** Upper y position of text */ int y);
+
     /**
     * Renders the given text centered on the x axis on the screen.
     */
@@ -143,6 +254,24 @@ public:
         /** The font size to render at. */ int fontSize,
         /** Upper y position of text. */int y);
 
+    /**
+    * Renders the given text in a font loaded with LoadFont, centered on the x axis on the screen.
+    */
+    void RenderCenteredText(/** Text to render. */ std::string text, /** The handle from LoadFont */ int font,
+        /** Upper y position of text. */int y);
+
+    /**
+    * Chooses between drawing text from cached glyph atlases (the default)
+    * and rendering a new surface and texture for every call.
+    */
+    void SetTextCaching(/** Whether to use glyph atlases */ bool enabled);
+
+    /**
+    * Returns (path, open sizes, file bytes, glyph atlas bytes) for every loaded font.
+    * All sizes of a font share one copy of the file.
+    */
+    std::vector<std::tuple<std::string, std::vector<int>, size_t, size_t>> GetFontMemoryUsage();
+
     /**
     * Sets the color to render text in.
     */
@@ -167,6 +296,27 @@ public:
     */
     void SetFramerate(/** Desired framerate */ int fps);
 
+    /**
+    * Returns how long the last frame took in milliseconds, as measured by ApplyFrameCap.
+    */
+    double GetFrameTime();
+
+    /**
+    * Returns how long the last frame took in seconds, for scaling movement by time.
+    */
+    double GetDeltaTime();
+
+    /**
+    * Returns the given percentile (0 to 100) of recent frame times in milliseconds.
+    */
+    double GetFrameTimePercentile(/** The percentile, e.g. 99 */ double percentile);
+
+    /**
+    * Returns the given percentile (0 to 100) of how far recent frame times strayed
+    * from their mean, in milliseconds.
+    */
+    double GetJitterPercentile(/** The percentile, e.g. 99 */ double percentile);
+
     /**
     * Checks for intersection between two rectangles.
     */
@@ -176,11 +326,108 @@ public:
         /** y position of second rectangle */ int y2, /** Width of decond rectangle */ int w2,
         /** Height of second rectangle */ int h2);
 
+    /**
+    * Reads the events that arrived since the last frame and takes a snapshot of the
+    * keyboard. Called by clear(), or by the first key check of a frame, so only games
+    * that check keys before clearing need to call it; calling it again before the next
+    * flip() does nothing.
+    */
+    void PollInput();
+
     /**
     * Checks to see if the given key is being pressed.
     */
     bool pressed(/** The key to check for */ std::string key);
 
+    /**
+    * Checks to see if the key with the given code, such as tinyengine.K_SPACE, is being pressed.
+    */
+    bool pressed(/** The key code to check for */ int key);
+
+    /**
+    * Checks to see if the given key went down this frame.
+    */
+    bool JustPressed(/** The key to check for */ std::string key);
+
+    /**
+    * Checks to see if the key with the given code went down this frame.
+    */
+    bool JustPressed(/** The key code to check for */ int key);
+
+    /**
+    * Checks to see if the given key came up this frame.
+    */
+    bool JustReleased(/** The key to check for */ std::string key);
+
+    /**
+    * Checks to see if the key with the given code came up this frame.
+    */
+    bool JustReleased(/** The key code to check for */ int key);
+
+    /**
+    * Brings the keyboard snapshot up to date, for checking keys as late as possible
+    * before drawing. Keys pressed since the frame started count as just pressed.
+    */
+    void LatchInput();
+
+    /**
+    * Returns how many milliseconds passed between the oldest key or button change shown
+    * by the last frame and that frame being presented, or 0 if it showed no new input.
+    */
+    double GetInputLatency();
+
+    /**
+    * Returns the given percentile (0 to 100) of recent input latencies in milliseconds.
+    */
+    double GetInputLatencyPercentile(/** The percentile, e.g. 99 */ double percentile);
+
+    /**
+    * Returns whether the window has been asked to close.
+    */
+    bool QuitRequested();
+
+    /**
+    * Starts or stops collecting events of the given types for PollEvents: "key_down",
+    * "key_up", "mouse_motion", "mouse_down", "mouse_up", "mouse_wheel",
+    * "controller_axis", "controller_down" and "controller_up". Input events of other
+    * types are dropped as they arrive. Returns false if a type is unknown.
+    */
+    bool SubscribeEvents(/** The event types */ std::vector<std::string> types,
+        /** Whether to collect them or stop collecting them */ bool subscribe);
+
+    /**
+    * Returns every subscribed event since the last call, oldest first.
+    */
+    const std::vector<InputEvent>& PollEvents();
+
+    /**
+    * Returns how many subscribed events were dropped because PollEvents was not called
+    * often enough.
+    */
+    int GetDroppedEvents();
+
+    /**
+    * Starts recording the keyboard every frame, to be replayed with StartReplay. The
+    * recording is written when StopRecording is called or the engine is destroyed.
+    */
+    void StartRecording(/** The file to write the recording to */ std::string path);
+
+    /**
+    * Writes the recording started with StartRecording. Returns false if it could not be written.
+    */
+    bool StopRecording();
+
+    /**
+    * Replays a recording in place of the real keyboard, starting next frame. Once it
+    * runs out, QuitRequested returns true. Returns false if it could not be read.
+    */
+    bool StartReplay(/** The file written by StopRecording */ std::string path);
+
+    /**
+    * Returns whether a recording is being replayed.
+    */
+    bool IsReplaying();
+
     /**
     * Draws a line from point a to point b.
     */
@@ -208,33 +455,268 @@ public:
     bool ShapeIntersect(/** First line list */ std::vector<std::pair<float, float>> a,
         /** second line list */ std::vector<std::pair<float, float>> b);
 
+    /**
+    * Turns batching of rectangles, lines and colors on or off. When on, they are
+    * recorded between clear() and flip() and submitted in merged runs.
+    */
+    void SetBatching(/** Whether primitives should be batched */ bool enabled);
+
+    /**
+    * Returns the number of draw calls made during the last frame: SDL calls for
+    * rectangles, lines and colors, or every draw with the OpenGL backend.
+    */
+    int GetDrawCallsSubmitted();
+
+    /**
+    * Returns the number of those draw calls batching saved during the last frame,
+    * compared with drawing each one on its own. 0 with batching off.
+    */
+    int GetDrawCallsSaved();
+
+    /**
+    * With the OpenGL backend, draws everything sharing a texture together each frame.
+    * This gives the fewest draw calls, but overlapping images may change order.
+    */
+    void SetSortByTexture(/** Whether batches are sorted by texture */ bool enabled);
+
+    /**
+    * Turns packing of small images into shared atlas pages on or off.
+    * Only affects images loaded afterwards.
+    */
+    void SetAtlasEnabled(/** Whether small images should be packed */ bool enabled);
+
+    /**
+    * Sets the width and height of atlas pages created from now on.
+    */
+    void SetAtlasPageSize(/** The page size in pixels */ int size);
+
+    /**
+    * Returns (images, used pixels, total pixels, fill ratio) for every atlas page.
+    */
+    std::vector<std::tuple<int, int, int, float>> GetAtlasStats();
+
+    /**
+    * Starts loading images, sound effects and fonts on background threads, so the
+    * first frame that uses them doesn't stall. Images become textures a few at a time
+    * during flip(). Returns a handle to check progress with.
+    */
+    std::shared_ptr<PreloadProgress> Preload(/** The resource paths */ std::vector<std::string> paths);
+
+    /**
+    * Maps an asset pack made by cook-assets.py. Resources in the pack are then loaded
+    * from it, already decoded, instead of from their own files. Returns false if the
+    * pack could not be opened.
+    */
+    bool LoadAssetPack(/** The pack file */ std::string path);
+
+    /**
+    * Limits how much memory "textures", "music", "sounds" or "fonts" may use. Once over,
+    * the least recently used are freed as new ones load. 0, the default, means no limit.
+    */
+    void SetCacheBudget(/** The kind of resource */ std::string kind, /** The budget in bytes */ size_t bytes);
+
+    /**
+    * Returns (kind, bytes used, budget, entries, hits, misses, evictions) for each kind of resource.
+    */
+    std::vector<std::tuple<std::string, size_t, size_t, int, int, int, int>> GetCacheStats();
+
+    /**
+    * Keeps a resource loaded whatever the cache budgets, until UnpinResource is called.
+    */
+    void PinResource(/** The filepath of the resource */ std::string path);
+
+    /**
+    * Lets a pinned resource be freed again.
+    */
+    void UnpinResource(/** The filepath of the resource */ std::string path);
+
+    /**
+    * Returns (paths, bytes) for resources found to be copies of one already loaded from
+    * another path, which share it instead of loading again.
+    */
+    std::pair<int, size_t> GetDedupStats();
+
+    /**
+    * Turns mipmaps on or off. When on, the default, images drawn at half their size or
+    * less are drawn from smaller, smoothed copies, which look better and draw faster.
+    * The copies are made when an image loads, so this only affects images loaded afterwards.
+    */
+    void SetMipmapsEnabled(/** Whether to use mipmaps */ bool enabled);
+
+    /**
+    * Stores an image's texture as "rgb565", for opaque images, or "argb4444", for images
+    * that look fine with 16 levels per channel, using half the memory. "native" goes back
+    * to the renderer's own format, which images use by default.
+    */
+    void SetTextureFormat(/** The filepath of the image */ std::string path, /** The format */ std::string format);
+
+    /**
+    * Returns the (width, height) of an image, or (0, 0) if it can't be read. The size is
+    * read from the file's header where possible, so the image isn't decoded.
+    */
+    std::pair<int, int> GetImageSize(/** The filepath of the image */ std::string path);
+
+    /**
+    * Watches a directory for changed resource files (Linux only). Each flip() reloads
+    * whatever changed and is loaded, so paths and handles show the new version.
+    * Returns False if the directory can't be watched.
+    */
+    bool WatchResources(/** The directory, written as resource paths under it start */ std::string directory);
+
+    /**
+    * Sets how many milliseconds each flip() may spend turning preloaded images into textures.
+    */
+    void SetPreloadBudget(/** The budget in milliseconds */ double milliseconds);
+
 private:
+    /** An image ready to draw with whichever backend is in use. */
+    struct Image {
+        /** Where the image lies for SDL_Renderer. */
+        TextureRegion region;
+        /** The image's texture for OpenGL. */
+        const GLTexture* glTexture;
+    };
+
+    /** An image loaded with LoadTexture. */
+    struct TextureHandle {
+        /** The filepath of the image. */
+        std::string path;
+        /** The loaded image. */
+        Image image;
+        /** Tells whether image is still cached. */
+        ResourceStamp stamp;
+        /** The frame width frames was looked up for. */
+        int frameWidth = 0;
+        /** The frame height frames was looked up for. */
+        int frameHeight = 0;
+        /** The sprite sheet's frame rectangles, looked up on the first DrawFrame. */
+        const std::vector<SDL_Rect>* frames = NULL;
+    };
+
+    /** A sound loaded with LoadSound. */
+    struct SoundHandle {
+        /** The filepath of the sound. */
+        std::string path;
+        /** The loaded sound. */
+        Mix_Chunk* chunk;
+        /** Tells whether chunk is still cached. */
+        ResourceStamp stamp;
+    };
+
+    /** A font loaded with LoadFont. */
+    struct FontHandle {
+        /** The filepath of the font. */
+        std::string path;
+        /** The font size. */
+        int size;
+        /** The glyphs of the font at this size. */
+        GlyphAtlas* atlas;
+    };
+
+    /** Loads an image for the backend in use, and stamps it if stamp isn't NULL. */
+    Image loadImage(const std::string& imgPath, ResourceStamp* stamp = NULL);
+
+    /** Returns the image behind a texture handle, loading it again if it was evicted. */
+    TextureHandle& getTextureHandle(int texture);
+
+    /** Draws part of an image, or all of it if src is NULL. */
+    void drawImage(const Image& image, const std::string& imgPath, const SDL_Rect* src, const SDL_Rect& dest);
+
+    /** Draws many copies of an image, as described for DrawImageBatch. */
+    void drawImageBatch(const Image& image, const int* rects, int count, int stride);
+
+    /** Handles the events waiting in the queue, so SDL's keyboard state is up to date. */
+    void pumpEvents();
+
+    /** Sees every event as SDL queues it, returning 0 to drop it. */
+    static int SDLCALL filterEvent(void* engine, SDL_Event* event);
+
     /** The height of the window. */
     int screenHeight;
     /** The width of the window. */
     int screenWidth;
 
-    /** The window we'll be rendering to. */
+    /** The window we'll be rendering to. NULL when headless. */
     SDL_Window* gWindow;
+    /** Whether the engine renders offscreen without a window. */
+    bool headlessMode = false;
+    /** The surface rendered into when headless. */
+    SDL_Surface* headlessSurface = NULL;
+    /** Whether anything is drawn at all. */
+    bool renderingEnabled = true;
     /** Our renderer. */
-    SDL_Renderer* gRenderer;
+    SDL_Renderer* gRenderer = NULL;
+    /** The OpenGL renderer, used instead of gRenderer when the "gl" backend is chosen. */
+    GLRenderer* glRenderer = NULL;
 
-    /** The current frame we are on in a given second of real time. */
-    int frameTickCount = 0;
     /** The current game framerate. */
     int framerate = 60;
-
-    /** The state of the all supported keys (pressed or not). */
-    static std::map<std::string, int> keymap;
+    /** Images loaded with LoadTexture, indexed by handle. */
+    std::vector<TextureHandle> textureHandles;
+    /** Sounds loaded with LoadSound, indexed by handle. */
+    std::vector<SoundHandle> soundHandles;
+    /** Fonts loaded with LoadFont, indexed by handle. */
+    std::vector<FontHandle> fontHandles;
+
+    /** Milliseconds each flip() may spend uploading preloaded images. */
+    double preloadBudget = 2.0;
+    /** Whether images drawn much smaller are drawn from their mipmaps. */
+    bool mipmapsEnabled = true;
+    /** Waits out the rest of each frame and measures frame times. */
+    FramePacer pacer;
+    /** Whether Run() should keep going. */
+    bool running = false;
+    /** Set once the window has been asked to close. */
+    bool quitRequested = false;
+    /** Updates Run() has dropped to avoid falling further and further behind. */
+    int droppedSteps = 0;
+
+    /** The keyboard as of this frame and the last. */
+    InputState input;
+    /** Whether PollInput() has run since the last flip(). */
+    bool inputPolled = false;
+    /** Measures how long input takes to be presented. */
+    InputLatency inputLatency;
+    /** The subscribed input events not yet polled. */
+    InputEventQueue inputEvents;
+    /** The events returned by the last PollEvents(). */
+    std::vector<InputEvent> polledEvents;
+    /** The keyboard being recorded or replayed. */
+    InputLog inputLog;
+    /** Where the recording goes, if recording. */
+    std::string recordingPath;
+    /** Whether the keyboard is being recorded. */
+    bool recording = false;
+    /** Whether a recording is being replayed. */
+    bool replaying = false;
 
     /** The color to use when rendering text. */
     SDL_Color textColor = { 255, 255, 255, 255 };
     /** The color to use when rendering the background. */
     SDL_Color backgroundColor = {255, 255, 255, 255};
+
+    /** Whether rectangles, lines and colors are recorded instead of drawn immediately. */
+    bool batching = true;
+    /** The rectangles, lines and colors recorded this frame. */
+    DrawCommandBuffer drawBuffer;
+    /** SDL draw calls made during the last frame. */
+    int lastFrameCallsSubmitted = 0;
+    /** SDL draw calls that immediate mode would have made during the last frame. */
+    int lastFrameCallsRecorded = 0;
+
+    /** Vertices of the current image batch, reused between batches. */
+    std::vector<SDL_Vertex> batchVertices;
+    /** Indices of the image batch quads. Only ever grows, since quad i always uses the same indices. */
+    std::vector<int> batchIndices;
+
+    /** The color primitives are drawn in with the OpenGL backend. */
+    SDL_Color drawColor = { 255, 255, 255, 255 };
+    /** Scratch glyph quads for drawing text with the OpenGL backend. */
+    std::vector<GlyphQuad> textQuads;
 };
 
 
-GameEngine::GameEngine(int w, int h, std::string title):screenWidth(w),screenHeight(h){
+GameEngine::GameEngine(int w, int h, std::string title, std::string backend, bool headless):screenWidth(w),screenHeight(h){
     // Initialization flag
     bool success = true;
     // String to hold any errors that occur.
@@ -242,14 +724,56 @@ GameEngine::GameEngine(int w, int h, std::string title):screenWidth(w),screenHei
     // The window we'll be rendering to
     gWindow = NULL;
 
+    const char* headlessEnv = SDL_getenv("TINYENGINE_HEADLESS");
+    headlessMode = headless || (headlessEnv != NULL && headlessEnv[0] != '\0' && std::string(headlessEnv) != "0");
+    if (headlessMode) {
+        // The dummy drivers need no display or sound card.
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+
+    // Benchmarks can record and replay any game's input without changing it.
+    const char* recordEnv = SDL_getenv("TINYENGINE_RECORD");
+    const char* replayEnv = SDL_getenv("TINYENGINE_REPLAY");
+    if (replayEnv != NULL && replayEnv[0] != '\0') {
+        StartReplay(replayEnv);
+    } else if (recordEnv != NULL && recordEnv[0] != '\0') {
+        StartRecording(recordEnv);
+    }
+
     // Initialize SDL
         if(SDL_Init(SDL_INIT_VIDEO) < 0){
             errorStream << "SDL could not initialize! SDL Error: " << SDL_GetError() << "\n";
             success = false;
         }
+        else if (headlessMode) {
+            if (backend != "sdl") {
+                SDL_Log("Headless mode always uses the software renderer\n");
+            }
+            headlessSurface = SDL_CreateRGBSurfaceWithFormat(0, screenWidth, screenHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+            if (headlessSurface != NULL) {
+                gRenderer = SDL_CreateSoftwareRenderer(headlessSurface);
+            }
+            if (gRenderer == NULL) {
+                errorStream << "Software renderer could not be created! SDL Error: " << SDL_GetError() << "\n";
+                success = false;
+            }
+        }
         else {
+            bool useGL = (backend == "gl");
+            Uint32 windowFlags = SDL_WINDOW_SHOWN;
+            if (useGL) {
+                SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+                SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+                SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+                SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+                windowFlags |= SDL_WINDOW_OPENGL;
+            } else if (backend != "sdl") {
+                SDL_Log("Unknown backend '%s', using sdl\n", backend.c_str());
+            }
+
             //Create window
-            gWindow = SDL_CreateWindow(title.c_str(), 100, 100, screenWidth, screenHeight, SDL_WINDOW_SHOWN );
+            gWindow = SDL_CreateWindow(title.c_str(), 100, 100, screenWidth, screenHeight, windowFlags );
 
             // Check if Window did not create.
             if(gWindow == NULL){
@@ -257,10 +781,16 @@ GameEngine::GameEngine(int w, int h, std::string title):screenWidth(w),screenHei
                 success = false;
             }
 
+            if (useGL && gWindow != NULL && !initGL()) {
+                SDL_Log("OpenGL 3.3 could not be initialized, falling back to SDL_Renderer\n");
+            }
+
             //Create a Renderer to draw on
-            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+            if (glRenderer == NULL) {
+                gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+            }
             // Check if Renderer did not create.
-            if(gRenderer == NULL){
+            if(gRenderer == NULL && glRenderer == NULL){
                 errorStream << "Renderer could not be created! SDL Error: " << SDL_GetError() << "\n";
                 success = false;
             }
@@ -268,6 +798,14 @@ GameEngine::GameEngine(int w, int h, std::string title):screenWidth(w),screenHei
 
         TTF_Init(); //TODO
 
+        if (success) {
+            // Every event passes through filterEvent as it is queued, including any queued already.
+            SDL_SetEventFilter(&GameEngine::filterEvent, this);
+            SDL_FilterEvents(&GameEngine::filterEvent, this);
+            // Input that arrives while the frame cap sleeps is then seen as it arrives.
+            pacer.setPumpEvents(!headlessMode);
+        }
+
         // If initialization did not work, then print out a list of errors in the constructor.
         if(!success){
             errorStream << "GameEngine::GameEngine - Failed to initialize!\n";
@@ -281,6 +819,17 @@ GameEngine::GameEngine(int w, int h, std::string title):screenWidth(w),screenHei
 
 // Proper shutdown of SDL and destroy initialized objects
 GameEngine::~GameEngine(){
+    StopRecording();
+    SDL_SetEventFilter(NULL, NULL);
+    // The OpenGL context has to go before its window.
+    delete glRenderer;
+    glRenderer = NULL;
+    if (headlessSurface != NULL) {
+        SDL_DestroyRenderer(gRenderer);
+        gRenderer = NULL;
+        SDL_FreeSurface(headlessSurface);
+        headlessSurface = NULL;
+    }
     //Destroy window
     SDL_DestroyWindow( gWindow );
     // Point gWindow to NULL to ensure it points to nothing.
@@ -295,6 +844,13 @@ bool GameEngine::initGL(){
     //Success flag
     bool success = true;
 
+    glRenderer = new GLRenderer(gWindow, screenWidth, screenHeight);
+    if (!glRenderer->isReady()) {
+        delete glRenderer;
+        glRenderer = NULL;
+        success = false;
+    }
+
     return success;
 }
 
@@ -304,17 +860,124 @@ void GameEngine::SetBackgroundColor(int r, int g, int b, int a) {
 
 // Clears the screen
 void GameEngine::clear() {
-    // Nothing yet!
+    PollInput();
+    if (!renderingEnabled) {
+        return;
+    }
+    drawColor = backgroundColor;
+    if (glRenderer != NULL) {
+        glRenderer->clear(backgroundColor);
+        return;
+    }
     SDL_SetRenderDrawColor(gRenderer, backgroundColor.r, backgroundColor.g, backgroundColor.b, backgroundColor.a);
     SDL_RenderClear(gRenderer);
+    drawBuffer.reset(backgroundColor);
 }
 
 // Flip
 // The flip function gets called once per loop
 // It swaps out the previvous frame in a double-buffering system
 void GameEngine::flip() {
-    // Nothing yet!
-    SDL_RenderPresent(gRenderer);
+    ResourceManager::instance().uploadPreloaded([this](const std::string& path) {
+        if (glRenderer != NULL) {
+            glRenderer->getTexture(path);
+        } else if (gRenderer != NULL) {
+            ResourceManager::instance().getTextureRegion(path, gRenderer);
+        }
+    }, preloadBudget);
+
+    if (renderingEnabled && glRenderer != NULL) {
+        glRenderer->present();
+    } else if (renderingEnabled) {
+        drawBuffer.flush(gRenderer);
+        lastFrameCallsRecorded = drawBuffer.getRecordedCalls();
+        lastFrameCallsSubmitted = drawBuffer.getSubmittedCalls();
+        SDL_RenderPresent(gRenderer);
+    }
+    inputLatency.presented();
+
+    // Changed files are swapped in once presented, when no queued draw still uses the old ones.
+    ResourceManager::instance().reloadChanged([this](const std::string& path, SDL_Surface* image) {
+        if (glRenderer != NULL) {
+            glRenderer->reloadTexture(path, image);
+        }
+    }, [](TTF_Font* old, TTF_Font* font) {
+        UIManager::instance().replaceFont(old, font);
+    });
+
+    // The next frame reads input afresh, once the input this one ended up with is recorded.
+    if (recording && inputPolled) {
+        inputLog.record(input.getKeys(), quitRequested);
+    }
+    inputPolled = false;
+}
+
+std::shared_ptr<PreloadProgress> GameEngine::Preload(std::vector<std::string> paths) {
+    // Sounds are decoded into the mixer's format, so it has to be open first.
+    SFXManager::instance();
+    return ResourceManager::instance().preload(paths);
+}
+
+bool GameEngine::LoadAssetPack(std::string path) {
+    return ResourceManager::instance().openAssetPack(path);
+}
+
+void GameEngine::SetCacheBudget(std::string kind, size_t bytes) {
+    if (!ResourceManager::instance().setCacheBudget(kind, bytes)) {
+        SDL_Log("Unknown cache '%s'", kind.c_str());
+    }
+}
+
+std::vector<std::tuple<std::string, size_t, size_t, int, int, int, int>> GameEngine::GetCacheStats() {
+    return ResourceManager::instance().getCacheStats();
+}
+
+void GameEngine::PinResource(std::string path) {
+    ResourceManager::instance().pin(path);
+}
+
+void GameEngine::UnpinResource(std::string path) {
+    ResourceManager::instance().unpin(path);
+}
+
+std::pair<int, size_t> GameEngine::GetDedupStats() {
+    return ResourceManager::instance().getDedupStats();
+}
+
+void GameEngine::SetMipmapsEnabled(bool enabled) {
+    mipmapsEnabled = enabled;
+    ResourceManager::instance().setMipmapsEnabled(enabled);
+    if (glRenderer != NULL) {
+        glRenderer->setMipmapsEnabled(enabled);
+    }
+}
+
+void GameEngine::SetTextureFormat(std::string path, std::string format) {
+    Uint32 pixelFormat;
+    if (format == "rgb565") {
+        pixelFormat = SDL_PIXELFORMAT_RGB565;
+    } else if (format == "argb4444") {
+        pixelFormat = SDL_PIXELFORMAT_ARGB4444;
+    } else if (format == "native") {
+        pixelFormat = 0;
+    } else {
+        SDL_Log("Unknown texture format '%s'", format.c_str());
+        return;
+    }
+    ResourceManager::instance().setTextureFormat(path, pixelFormat);
+}
+
+std::pair<int, int> GameEngine::GetImageSize(std::string path) {
+    SDL_Point size = ResourceManager::instance().getIMGDimensions(path);
+    return std::make_pair(size.x, size.y);
+}
+
+bool GameEngine::WatchResources(std::string directory) {
+    return ResourceManager::instance().watch(directory);
+}
+
+void GameEngine::SetPreloadBudget(double milliseconds) {
+    preloadBudget = milliseconds;
 }
 
 void GameEngine::delay(int milliseconds) {
@@ -350,52 +1013,344 @@ void GameEngine::loop(){
     SDL_StopTextInput();
 }
 
+void GameEngine::Run(std::function<void(double)> update, std::function<void(double)> render, int hz, int maxSteps) {
+    if (hz <= 0) {
+        SDL_Log("Run needs a positive update rate, got %d", hz);
+        return;
+    }
+    const double step = 1.0 / hz;
+    const double frequency = (double) SDL_GetPerformanceFrequency();
+    Uint64 previous = SDL_GetPerformanceCounter();
+    double accumulator = 0;
+    running = true;
+    droppedSteps = 0;
+
+    while (running) {
+        // Catch the window closing even if the game never checks for input.
+        SDL_PumpEvents();
+        SDL_Event e;
+        if (SDL_PeepEvents(&e, 1, SDL_GETEVENT, SDL_QUIT, SDL_QUIT) > 0) {
+            quitRequested = true;
+        }
+        if (quitRequested) {
+            break;
+        }
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (headlessMode) {
+            // Headless runs have no display to keep up with, so each frame is exactly one update.
+            accumulator += step;
+        } else {
+            accumulator += (now - previous) / frequency;
+        }
+        previous = now;
+
+        int steps = 0;
+        while (accumulator >= step && steps < maxSteps && running) {
+            update(step);
+            accumulator -= step;
+            steps++;
+        }
+        // Too far behind to catch up: drop the backlog rather than spiral.
+        if (accumulator >= step) {
+            int dropped = (int) (accumulator / step);
+            droppedSteps += dropped;
+            accumulator -= dropped * step;
+        }
+
+        clear();
+        render(accumulator / step);
+        flip();
+        ApplyFrameCap();
+    }
+    running = false;
+}
+
+void GameEngine::Stop() {
+    running = false;
+}
+
+int GameEngine::GetDroppedSteps() {
+    return droppedSteps;
+}
+
 // Get Pointer to Window
 SDL_Window* GameEngine::getSDLWindow(){
     return gWindow;
 }
 
+bool GameEngine::IsHeadless() {
+    return headlessMode;
+}
+
+void GameEngine::SetRenderingEnabled(bool enabled) {
+    renderingEnabled = enabled;
+}
+
 // Okay, render our rectangles!
 void GameEngine::DrawRectangle(int x, int y, int w, int h, bool fill){
+    if (!renderingEnabled) {
+        return;
+    }
     SDL_Rect fillRect = {x,y,w,h};
-    if (fill) {
-        SDL_RenderFillRect(gRenderer, &fillRect);
+    if (glRenderer != NULL) {
+        if (fill) {
+            glRenderer->fillRect(fillRect, drawColor);
+        } else {
+            glRenderer->drawRect(fillRect, drawColor);
+        }
+    } else if (batching) {
+        if (fill) {
+            drawBuffer.fillRect(fillRect);
+        } else {
+            drawBuffer.drawRect(fillRect);
+        }
     } else {
-        SDL_RenderDrawRect(gRenderer, &fillRect);
+        if (fill) {
+            SDL_RenderFillRect(gRenderer, &fillRect);
+        } else {
+            SDL_RenderDrawRect(gRenderer, &fillRect);
+        }
+        drawBuffer.countImmediate();
     }
 }
 
 void GameEngine::SetColor(int r, int g, int b, int a) {
-    SDL_SetRenderDrawColor(gRenderer, r, g, b, a);
+    drawColor = { (uint8_t) r, (uint8_t) g, (uint8_t) b, (uint8_t) a };
+    if (glRenderer != NULL) {
+        return;
+    }
+    if (batching) {
+        drawBuffer.setColor(drawColor);
+    } else {
+        SDL_SetRenderDrawColor(gRenderer, r, g, b, a);
+        drawBuffer.countImmediate();
+    }
+}
+
+void GameEngine::SetBatching(bool enabled) {
+    if (gRenderer != NULL) {
+        drawBuffer.flush(gRenderer);
+    }
+    batching = enabled;
+}
+
+int GameEngine::GetDrawCallsSubmitted() {
+    if (glRenderer != NULL) {
+        return glRenderer->getDrawCalls();
+    }
+    return lastFrameCallsSubmitted;
+}
+
+int GameEngine::GetDrawCallsSaved() {
+    if (glRenderer != NULL) {
+        return std::max(0, glRenderer->getPrimitives() - glRenderer->getDrawCalls());
+    }
+    return lastFrameCallsRecorded - lastFrameCallsSubmitted;
+}
+
+void GameEngine::SetSortByTexture(bool enabled) {
+    if (glRenderer != NULL) {
+        glRenderer->setSortByTexture(enabled);
+    }
+}
+
+void GameEngine::SetAtlasEnabled(bool enabled) {
+    ResourceManager::instance().setAtlasEnabled(enabled);
+}
+
+void GameEngine::SetAtlasPageSize(int size) {
+    ResourceManager::instance().setAtlasPageSize(size);
+}
+
+std::vector<std::tuple<int, int, int, float>> GameEngine::GetAtlasStats() {
+    return ResourceManager::instance().getAtlasStats();
 }
 
 void GameEngine::DrawImage(std::string imgPath, int x, int y, int w, int h) {
-    SDL_Texture* texture = ResourceManager::instance().getTexture(imgPath, gRenderer);
+    if (!renderingEnabled) {
+        return;
+    }
+    SDL_Rect dest = { x, y, w, h };
+    drawImage(loadImage(imgPath), imgPath, NULL, dest);
+}
+
+void GameEngine::DrawImage(int texture, int x, int y, int w, int h) {
+    if (!renderingEnabled || texture < 0 || texture >= (int) textureHandles.size()) {
+        return;
+    }
     SDL_Rect dest = { x, y, w, h };
-    SDL_RenderCopy(gRenderer, texture, NULL, &dest);
+    TextureHandle& handle = getTextureHandle(texture);
+    drawImage(handle.image, handle.path, NULL, dest);
+}
+
+void GameEngine::drawImage(const Image& image, const std::string& imgPath, const SDL_Rect* src, const SDL_Rect& dest) {
+    if (glRenderer != NULL) {
+        glRenderer->drawTexture(image.glTexture, src, dest);
+        return;
+    }
+    // Anything batched so far has to land underneath the image.
+    drawBuffer.flush(gRenderer);
+    SDL_Texture* texture = image.region.texture;
+    SDL_Rect region = image.region.rect;
+    if (src != NULL) {
+        // Source rectangles are relative to the image, which may sit anywhere in an atlas page.
+        region = { region.x + src->x, region.y + src->y, src->w, src->h };
+    }
+    if (mipmapsEnabled) {
+        // Drawn at half size or less, a smaller copy looks smoother and reads fewer texels.
+        int level = MipChain::levelFor(region.w, region.h, dest.w, dest.h);
+        SDL_Texture* mip = ResourceManager::instance().getMip(imgPath, level);
+        if (mip != NULL) {
+            texture = mip;
+            region = { region.x >> level, region.y >> level, std::max(region.w >> level, 1), std::max(region.h >> level, 1) };
+        }
+    }
+    SDL_RenderCopy(gRenderer, texture, &region, &dest);
+}
+
+GameEngine::TextureHandle& GameEngine::getTextureHandle(int texture) {
+    TextureHandle& handle = textureHandles[texture];
+    if (!ResourceManager::instance().isCurrent(handle.stamp)) {
+        handle.image = loadImage(handle.path, &handle.stamp);
+        // A reloaded sheet may have a new size, and so new frames.
+        handle.frames = NULL;
+    }
+    return handle;
+}
+
+GameEngine::Image GameEngine::loadImage(const std::string& imgPath, ResourceStamp* stamp) {
+    Image image = { { NULL, { 0, 0, 0, 0 } }, NULL };
+    if (glRenderer != NULL) {
+        image.glTexture = glRenderer->getTexture(imgPath, stamp);
+    } else {
+        image.region = ResourceManager::instance().getTextureRegion(imgPath, gRenderer, stamp);
+    }
+    return image;
+}
+
+void GameEngine::DrawImageBatch(std::string imgPath, const int* rects, int count, int stride) {
+    if (count <= 0 || !renderingEnabled) {
+        return;
+    }
+    drawImageBatch(loadImage(imgPath), rects, count, stride);
+}
+
+void GameEngine::DrawImageBatch(int texture, const int* rects, int count, int stride) {
+    if (count <= 0 || !renderingEnabled || texture < 0 || texture >= (int) textureHandles.size()) {
+        return;
+    }
+    drawImageBatch(getTextureHandle(texture).image, rects, count, stride);
 }
 
-static int getNumColumns(std::string fileName, int frameWidth) {
-    SDL_Point dimensions = ResourceManager::instance().getIMGDimensions(fileName);
-    int width = dimensions.x;
-    return (width / frameWidth);
+void GameEngine::drawImageBatch(const Image& image, const int* rects, int count, int stride) {
+    if (glRenderer != NULL) {
+        for (int i = 0; i < count; i++) {
+            const int* r = rects + i * stride;
+            SDL_Rect dest = { r[0], r[1], r[2], r[3] };
+            SDL_Rect src = { 0, 0, 0, 0 };
+            if (stride == 8) {
+                src = { r[4], r[5], r[6], r[7] };
+            }
+            glRenderer->drawTexture(image.glTexture, stride == 8 ? &src : NULL, dest);
+        }
+        return;
+    }
+    drawBuffer.flush(gRenderer);
+
+    if (image.region.texture == NULL) {
+        return;
+    }
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+    // SDL_RenderGeometry only arrived in SDL 2.0.18.
+    for (int i = 0; i < count; i++) {
+        const int* r = rects + i * stride;
+        SDL_Rect dest = { r[0], r[1], r[2], r[3] };
+        SDL_Rect src = image.region.rect;
+        if (stride == 8) {
+            src = { image.region.rect.x + r[4], image.region.rect.y + r[5], r[6], r[7] };
+        }
+        SDL_RenderCopy(gRenderer, image.region.texture, &src, &dest);
+    }
+#else
+    int texW = 0;
+    int texH = 0;
+    SDL_QueryTexture(image.region.texture, NULL, NULL, &texW, &texH);
+
+    while ((int) batchIndices.size() < count * 6) {
+        int base = (int) batchIndices.size() / 6 * 4;
+        int quad[6] = { base, base + 1, base + 2, base + 2, base + 3, base };
+        batchIndices.insert(batchIndices.end(), quad, quad + 6);
+    }
+
+    batchVertices.resize(count * 4);
+    SDL_Color white = { 255, 255, 255, 255 };
+    for (int i = 0; i < count; i++) {
+        const int* r = rects + i * stride;
+        float x0 = r[0];
+        float y0 = r[1];
+        float x1 = (float) (r[0] + r[2]);
+        float y1 = (float) (r[1] + r[3]);
+
+        // Source rectangles are relative to the image, which may sit anywhere in an atlas page.
+        SDL_Rect src = image.region.rect;
+        if (stride == 8) {
+            src = { image.region.rect.x + r[4], image.region.rect.y + r[5], r[6], r[7] };
+        }
+        float u0 = (float) src.x / texW;
+        float v0 = (float) src.y / texH;
+        float u1 = (float) (src.x + src.w) / texW;
+        float v1 = (float) (src.y + src.h) / texH;
+
+        SDL_Vertex* v = &batchVertices[i * 4];
+        v[0] = { { x0, y0 }, white, { u0, v0 } };
+        v[1] = { { x1, y0 }, white, { u1, v0 } };
+        v[2] = { { x1, y1 }, white, { u1, v1 } };
+        v[3] = { { x0, y1 }, white, { u0, v1 } };
+    }
+
+    SDL_RenderGeometry(gRenderer, image.region.texture, batchVertices.data(), count * 4, batchIndices.data(), count * 6);
+#endif
 }
 
 void GameEngine::DrawFrame(std::string imgPath, int frameTick, int spriteNumFrames,
     int x, int y, int frameWidth, int frameHeight) {
-
-    SDL_Texture* texture = ResourceManager::instance().getTexture(imgPath, gRenderer);
+    if (!renderingEnabled) {
+        return;
+    }
 
     int currentFrame = frameTick * spriteNumFrames / framerate;
+    SDL_Rect dest = { x, y, frameWidth, frameHeight };
 
-    int numColumns = getNumColumns(imgPath, frameWidth);
+    // Load the sheet first so its size is recorded without decoding it a second time.
+    Image image = loadImage(imgPath);
+    const std::vector<SDL_Rect>& frames = ResourceManager::instance().getFrameRects(imgPath, frameWidth, frameHeight);
+    if (!frames.empty()) {
+        // Copied, since the table may be dropped by the time the mip level is looked up.
+        SDL_Rect frame = frames[(size_t) currentFrame % frames.size()];
+        drawImage(image, imgPath, &frame, dest);
+    }
+}
 
-    int frameRectX = (currentFrame % numColumns) * frameWidth;
-    int frameRectY = (currentFrame / numColumns) * frameHeight;
-    SDL_Rect src = { frameRectX, frameRectY, frameWidth, frameHeight };
-    SDL_Rect dest = { x, y, frameWidth, frameHeight };
+void GameEngine::DrawFrame(int texture, int frameTick, int spriteNumFrames,
+    int x, int y, int frameWidth, int frameHeight) {
+    if (!renderingEnabled || texture < 0 || texture >= (int) textureHandles.size()) {
+        return;
+    }
 
-    SDL_RenderCopy(gRenderer, texture, &src, &dest);
+    TextureHandle& sheet = getTextureHandle(texture);
+    if (sheet.frames == NULL || sheet.frameWidth != frameWidth || sheet.frameHeight != frameHeight) {
+        sheet.frames = &ResourceManager::instance().getFrameRects(sheet.path, frameWidth, frameHeight);
+        sheet.frameWidth = frameWidth;
+        sheet.frameHeight = frameHeight;
+    }
+
+    int currentFrame = frameTick * spriteNumFrames / framerate;
+    SDL_Rect dest = { x, y, frameWidth, frameHeight };
+    if (!sheet.frames->empty()) {
+        SDL_Rect frame = (*sheet.frames)[(size_t) currentFrame % sheet.frames->size()];
+        drawImage(sheet.image, sheet.path, &frame, dest);
+    }
 }
 
 void GameEngine::PlayMusic(std::string path) {
@@ -411,6 +1366,55 @@ void GameEngine::PlaySFX(std::string path) {
     SFXManager::instance().playSFX(path);
 }
 
+void GameEngine::PlaySFX(int sound) {
+    if (sound < 0 || sound >= (int) soundHandles.size()) {
+        return;
+    }
+    SoundHandle& handle = soundHandles[sound];
+    ResourceManager& resources = ResourceManager::instance();
+    if (!resources.isCurrent(handle.stamp)) {
+        // The sound may have been evicted since it was loaded.
+        handle.chunk = resources.getSFX(handle.path, &handle.stamp);
+    }
+    SFXManager::instance().playSFX(handle.chunk);
+}
+
+int GameEngine::LoadTexture(std::string path) {
+    TextureHandle handle;
+    handle.path = path;
+    handle.image = loadImage(path, &handle.stamp);
+    if (handle.image.region.texture == NULL && handle.image.glTexture == NULL) {
+        SDL_Log("Failed to load texture %s", path.c_str());
+        return -1;
+    }
+    textureHandles.push_back(handle);
+    return (int) textureHandles.size() - 1;
+}
+
+int GameEngine::LoadSound(std::string path) {
+    SFXManager::instance();
+    ResourceStamp stamp;
+    Mix_Chunk* sound = ResourceManager::instance().getSFX(path, &stamp);
+    if (sound == NULL) {
+        return -1;
+    }
+    SoundHandle handle = { path, sound, stamp };
+    soundHandles.push_back(handle);
+    return (int) soundHandles.size() - 1;
+}
+
+int GameEngine::LoadFont(std::string path, int size) {
+    FontHandle handle;
+    handle.path = path;
+    handle.size = size;
+    handle.atlas = UIManager::instance().getGlyphAtlas(path, size);
+    if (handle.atlas == NULL) {
+        return -1;
+    }
+    fontHandles.push_back(handle);
+    return (int) fontHandles.size() - 1;
+}
+
 void GameEngine::SetMusicVolume(int volume) {
     SFXManager::instance().setMusicVolume(volume);
 }
@@ -424,25 +1428,120 @@ void GameEngine::SetTextColor(int r, int g, int b, int a) {
 }
 
 void GameEngine::RenderText(std::string text, std::string fontStyle, int fontSize, int x, int y) {
+    if (!renderingEnabled) {
+        return;
+    }
+    if (glRenderer != NULL) {
+        GlyphAtlas* atlas = UIManager::instance().getGlyphAtlas(fontStyle, fontSize);
+        if (atlas != NULL) {
+            textQuads.clear();
+            atlas->layout(text, x, y, textQuads);
+            glRenderer->drawText(atlas, textQuads, textColor);
+        }
+        return;
+    }
+    drawBuffer.flush(gRenderer);
     UIManager::instance().renderText(gRenderer, text, fontStyle, fontSize, textColor, x, y);
 }
 
+void GameEngine::RenderText(std::string text, int font, int x, int y) {
+    if (!renderingEnabled || font < 0 || font >= (int) fontHandles.size()) {
+        return;
+    }
+    const FontHandle& handle = fontHandles[font];
+    if (glRenderer != NULL) {
+        textQuads.clear();
+        handle.atlas->layout(text, x, y, textQuads);
+        glRenderer->drawText(handle.atlas, textQuads, textColor);
+        return;
+    }
+    drawBuffer.flush(gRenderer);
+    if (UIManager::instance().isGlyphCacheEnabled()) {
+        UIManager::instance().drawText(gRenderer, handle.atlas, text, textColor, x, y);
+    } else {
+        UIManager::instance().renderText(gRenderer, text, handle.path, handle.size, textColor, x, y);
+    }
+}
+
 void GameEngine::RenderCenteredText(std::string text, std::string fontStyle, int fontSize, int y) {
+    if (!renderingEnabled) {
+        return;
+    }
+    if (glRenderer != NULL) {
+        GlyphAtlas* atlas = UIManager::instance().getGlyphAtlas(fontStyle, fontSize);
+        if (atlas != NULL) {
+            int x = (screenWidth - atlas->measure(text)) / 2;
+            textQuads.clear();
+            atlas->layout(text, x, y, textQuads);
+            glRenderer->drawText(atlas, textQuads, textColor);
+        }
+        return;
+    }
+    drawBuffer.flush(gRenderer);
     UIManager::instance().renderCenteredText(gRenderer, text, fontStyle, fontSize, textColor, y, screenWidth);
 }
 
+void GameEngine::RenderCenteredText(std::string text, int font, int y) {
+    if (!renderingEnabled || font < 0 || font >= (int) fontHandles.size()) {
+        return;
+    }
+    const FontHandle& handle = fontHandles[font];
+    if (glRenderer != NULL || UIManager::instance().isGlyphCacheEnabled()) {
+        RenderText(text, font, (screenWidth - handle.atlas->measure(text)) / 2, y);
+        return;
+    }
+    drawBuffer.flush(gRenderer);
+    UIManager::instance().renderCenteredText(gRenderer, text, handle.path, handle.size, textColor, y, screenWidth);
+}
+
+void GameEngine::SetTextCaching(bool enabled) {
+    UIManager::instance().setGlyphCacheEnabled(enabled);
+}
+
+std::vector<std::tuple<std::string, std::vector<int>, size_t, size_t>> GameEngine::GetFontMemoryUsage() {
+    std::vector<std::tuple<std::string, std::vector<int>, size_t, size_t>> usage;
+    auto fonts = ResourceManager::instance().getFontMemoryUsage();
+    for (auto it = fonts.begin(); it != fonts.end(); ++it) {
+        const std::string& path = std::get<0>(*it);
+        usage.push_back(std::make_tuple(path, std::get<1>(*it), std::get<2>(*it),
+            UIManager::instance().getGlyphAtlasMemoryUsage(path)));
+    }
+    return usage;
+}
+
 
 void GameEngine::ApplyFrameCap() {
-    int tickCount = SDL_GetTicks();
-    int delayTime = 1000 / framerate - (tickCount - frameTickCount);
-    if (delayTime > 0) {
-        SDL_Delay(delayTime);
+    // Headless runs go as fast as they can.
+    if (headlessMode) {
+        pacer.tick();
+    } else {
+        pacer.wait();
     }
-    frameTickCount = tickCount;
 }
 
 void GameEngine::SetFramerate(int fps) {
     framerate = fps;
+    pacer.setFramerate(fps);
+}
+
+double GameEngine::GetFrameTime() {
+    return pacer.getFrameTime();
+}
+
+double GameEngine::GetDeltaTime() {
+    // Recorded runs step by exactly one frame, so replaying them moves everything the same way.
+    if ((recording || replaying) && framerate > 0) {
+        return 1.0 / framerate;
+    }
+    return pacer.getDeltaTime();
+}
+
+double GameEngine::GetFrameTimePercentile(double percentile) {
+    return pacer.getFrameTimePercentile(percentile);
+}
+
+double GameEngine::GetJitterPercentile(double percentile) {
+    return pacer.getJitterPercentile(percentile);
 }
 
 bool GameEngine::RectIntersect(int x1, int y1, int w1, int h1, int x2, int y2, int w2, int h2) {
@@ -452,117 +1551,173 @@ bool GameEngine::RectIntersect(int x1, int y1, int w1, int h1, int x2, int y2, i
     return SDL_HasIntersection(&r1, &r2);
 }
 
-std::map<std::string, int> GameEngine::keymap = []
-{
-    std::map<std::string, int> binds;
-    binds["esc"] = SDLK_ESCAPE;
-    binds["f1"] = SDLK_F1;
-    binds["f2"] = SDLK_F2;
-    binds["f3"] = SDLK_F3;
-    binds["f4"] = SDLK_F4;
-    binds["f5"] = SDLK_F5;
-    binds["f6"] = SDLK_F6;
-    binds["f7"] = SDLK_F7;
-    binds["f8"] = SDLK_F8;
-    binds["f9"] = SDLK_F9;
-    binds["f10"] = SDLK_F10;
-    binds["f11"] = SDLK_F11;
-    binds["f12"] = SDLK_F12;
-    binds["delete"] = SDLK_DELETE;
-    binds["home"] = SDLK_HOME;
-
-    binds["`"] = SDLK_BACKQUOTE;
-    binds["1"] = SDLK_1;
-    binds["2"] = SDLK_2;
-    binds["3"] = SDLK_3;
-    binds["4"] = SDLK_4;
-    binds["5"] = SDLK_5;
-    binds["6"] = SDLK_6;
-    binds["7"] = SDLK_7;
-    binds["8"] = SDLK_8;
-    binds["9"] = SDLK_9;
-    binds["0"] = SDLK_0;
-    binds["-"] = SDLK_MINUS;
-    binds["="] = SDLK_EQUALS;
-    binds["back"] = SDLK_BACKSPACE;
-
-    binds["tab"] = SDLK_TAB;
-    binds["q"] = SDLK_q;
-    binds["w"] = SDLK_w;
-    binds["e"] = SDLK_e;
-    binds["r"] = SDLK_r;
-    binds["t"] = SDLK_t;
-    binds["y"] = SDLK_y;
-    binds["u"] = SDLK_u;
-    binds["i"] = SDLK_i;
-    binds["o"] = SDLK_o;
-    binds["p"] = SDLK_p;
-    binds["["] = SDLK_LEFTBRACKET;
-    binds["]"] = SDLK_RIGHTBRACKET;
-    binds["\\"] = SDLK_BACKSLASH;
-
-    binds["capslock"] = SDLK_CAPSLOCK;
-    binds["a"] = SDLK_a;
-    binds["s"] = SDLK_s;
-    binds["d"] = SDLK_d;
-    binds["f"] = SDLK_f;
-    binds["g"] = SDLK_g;
-    binds["h"] = SDLK_h;
-    binds["j"] = SDLK_j;
-    binds["k"] = SDLK_k;
-    binds["l"] = SDLK_l;
-    binds[";"] = SDLK_SEMICOLON;
-    binds["'"] = SDLK_QUOTE;
-    binds["return"] = SDLK_RETURN;
-
-    binds["l_shift"] = SDLK_LSHIFT;
-    binds["z"] = SDLK_z;
-    binds["x"] = SDLK_x;
-    binds["c"] = SDLK_c;
-    binds["v"] = SDLK_v;
-    binds["b"] = SDLK_b;
-    binds["n"] = SDLK_n;
-    binds["m"] = SDLK_m;
-    binds[","] = SDLK_COMMA;
-    binds["."] = SDLK_PERIOD;
-    binds["/"] = SDLK_SLASH;
-    binds["r_shift"] = SDLK_RSHIFT;
-
-    binds["l_ctrl"] = SDLK_LCTRL;
-    binds["l_alt"] = SDLK_LALT;
-    binds["space"] = SDLK_SPACE;
-    binds["r_alt"] = SDLK_RALT;
-    binds["r_ctrl"] = SDLK_RCTRL;
-    binds["up"] = SDLK_UP;
-    binds["down"] = SDLK_DOWN;
-    binds["left"] = SDLK_LEFT;
-    binds["right"] = SDLK_RIGHT;
-
-    return binds;
-}();
-
-bool GameEngine::pressed(std::string key){
-    static std::map<int, bool> pressed;
+int SDLCALL GameEngine::filterEvent(void* engine, SDL_Event* event) {
+    GameEngine* self = static_cast<GameEngine*>(engine);
+    self->inputLatency.arrived(*event);
+    return self->inputEvents.filter(*event) ? 1 : 0;
+}
 
-    // from https://stackoverflow.com/questions/11699183/what-is-the-best-way-to-read-input-from-keyboard-using-sdl
+void GameEngine::pumpEvents() {
     SDL_Event event;
-    while( SDL_PollEvent(&event)) {
-        switch(event.type) {
-            case SDL_KEYDOWN:
-                pressed[event.key.keysym.sym] = true;
-                break;
-            case SDL_KEYUP:
-                pressed[event.key.keysym.sym] = false;
-                break;
+    while (SDL_PollEvent(&event)) {
+        if (event.type == SDL_QUIT) {
+            quitRequested = true;
+        } else if (event.type == SDL_CONTROLLERDEVICEADDED) {
+            SDL_GameControllerOpen(event.cdevice.which);
+        } else if (event.type == SDL_CONTROLLERDEVICEREMOVED) {
+            SDL_GameControllerClose(SDL_GameControllerFromInstanceID(event.cdevice.which));
+        }
+    }
+}
+
+bool GameEngine::SubscribeEvents(std::vector<std::string> types, bool subscribe) {
+    bool known = true;
+    for (size_t i = 0; i < types.size(); i++) {
+        int type = InputEventQueue::typeOf(types[i]);
+        if (type == 0) {
+            SDL_Log("Unknown event type '%s'\n", types[i].c_str());
+            known = false;
+            continue;
+        }
+        if (subscribe && type >= INPUT_CONTROLLER_AXIS && SDL_WasInit(SDL_INIT_GAMECONTROLLER) == 0) {
+            // Controllers already plugged in are announced, and opened, as if just added.
+            if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) < 0) {
+                SDL_Log("Controllers could not be initialized! SDL Error: %s\n", SDL_GetError());
             }
+        }
+        inputEvents.subscribe(type, subscribe);
     }
+    return known;
+}
+
+const std::vector<InputEvent>& GameEngine::PollEvents() {
+    pumpEvents();
+    inputEvents.drain(polledEvents);
+    return polledEvents;
+}
 
-    return pressed[keymap[key]];
+int GameEngine::GetDroppedEvents() {
+    return inputEvents.getDropped();
+}
+
+void GameEngine::PollInput() {
+    if (inputPolled) {
+        return;
+    }
+    inputPolled = true;
+    pumpEvents();
+
+    if (replaying) {
+        InputState::Keys keys;
+        bool quit = false;
+        if (inputLog.replay(keys, quit)) {
+            input.update(keys);
+            quitRequested = quitRequested || quit;
+        } else {
+            SDL_Log("Replayed all %u frames\n", inputLog.getFrames());
+            replaying = false;
+            input.update(InputState::Keys());
+            quitRequested = true;
+        }
+    } else {
+        input.update();
+    }
+    inputLatency.sampled();
+}
+
+void GameEngine::LatchInput() {
+    PollInput();
+    // Replays already hold each frame's input as of the end of the frame.
+    if (!replaying) {
+        pumpEvents();
+        input.latch();
+        inputLatency.sampled();
+    }
+}
+
+double GameEngine::GetInputLatency() {
+    return inputLatency.getLatency();
+}
+
+double GameEngine::GetInputLatencyPercentile(double percentile) {
+    return inputLatency.getLatencyPercentile(percentile);
+}
+
+bool GameEngine::pressed(std::string key){
+    return pressed(KeyNames::find(key.c_str()));
+}
+
+bool GameEngine::pressed(int key) {
+    PollInput();
+    return input.pressed((SDL_Scancode) key);
+}
+
+bool GameEngine::JustPressed(std::string key) {
+    return JustPressed(KeyNames::find(key.c_str()));
+}
+
+bool GameEngine::JustPressed(int key) {
+    PollInput();
+    return input.justPressed((SDL_Scancode) key);
+}
+
+bool GameEngine::JustReleased(std::string key) {
+    return JustReleased(KeyNames::find(key.c_str()));
+}
+
+bool GameEngine::JustReleased(int key) {
+    PollInput();
+    return input.justReleased((SDL_Scancode) key);
+}
+
+bool GameEngine::QuitRequested() {
+    PollInput();
+    return quitRequested;
+}
+
+void GameEngine::StartRecording(std::string path) {
+    replaying = false;
+    inputLog.startRecording();
+    recordingPath = path;
+    recording = true;
+}
+
+bool GameEngine::StopRecording() {
+    if (!recording) {
+        return false;
+    }
+    recording = false;
+    if (!inputLog.save(recordingPath)) {
+        SDL_Log("Could not write the input recording to %s\n", recordingPath.c_str());
+        return false;
+    }
+    SDL_Log("Recorded %u frames of input to %s\n", inputLog.getFrames(), recordingPath.c_str());
+    return true;
+}
+
+bool GameEngine::StartReplay(std::string path) {
+    StopRecording();
+    replaying = inputLog.load(path);
+    return replaying;
+}
+
+bool GameEngine::IsReplaying() {
+    return replaying;
 }
 
 // Draws a line from point a to point b
 void GameEngine::DrawLine(std::pair<float, float> a, std::pair<float, float> b) {
-    SDL_RenderDrawLine(gRenderer, a.first, a.second, b.first, b.second);
+    if (!renderingEnabled) {
+        return;
+    }
+    if (glRenderer != NULL) {
+        glRenderer->drawLine(a.first, a.second, b.first, b.second, drawColor);
+    } else if (batching) {
+        drawBuffer.drawLine(a.first, a.second, b.first, b.second);
+    } else {
+        SDL_RenderDrawLine(gRenderer, a.first, a.second, b.first, b.second);
+        drawBuffer.countImmediate();
+    }
 }
 
 // Draws a list of line
@@ -632,9 +1787,58 @@ bool GameEngine::ShapeIntersect(std::vector<std::pair<float, float>> a, std::vec
 // Include the pybindings
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/functional.h>
 
 namespace py = pybind11;
 
+// Unpacks the rectangles given to DrawImageBatch, which may be either a
+// contiguous int32 buffer shaped (N, 4) or (N, 8), or a sequence of 4- or
+// 8-tuples.
+template <typename Image>
+static void drawImageBatch(GameEngine& engine, Image imgPath, py::object rects) {
+    if (py::isinstance<py::buffer>(rects)) {
+        py::buffer_info info = py::cast<py::buffer>(rects).request();
+        if (info.itemsize != sizeof(int) || (info.format != "i" && info.format != "l")) {
+            throw py::type_error("DrawImageBatch expects an int32 buffer");
+        }
+        if (info.ndim != 1 && info.ndim != 2) {
+            throw py::value_error("DrawImageBatch expects a contiguous (N, 4) or (N, 8) buffer");
+        }
+        int stride = info.ndim == 2 ? (int) info.shape[1] : 4;
+        bool contiguous = info.ndim == 1
+            ? info.strides[0] == (ssize_t) sizeof(int)
+            : info.strides[1] == (ssize_t) sizeof(int) && info.strides[0] == (ssize_t) (stride * sizeof(int));
+        if ((stride != 4 && stride != 8) || !contiguous) {
+            throw py::value_error("DrawImageBatch expects a contiguous (N, 4) or (N, 8) buffer");
+        }
+        if (info.ndim == 1 && info.shape[0] % 4 != 0) {
+            throw py::value_error("DrawImageBatch expects a flat buffer of 4 values per rectangle");
+        }
+        int count = (int) (info.ndim == 2 ? info.shape[0] : info.shape[0] / 4);
+        engine.DrawImageBatch(imgPath, static_cast<const int*>(info.ptr), count, stride);
+        return;
+    }
+
+    py::sequence items = py::cast<py::sequence>(rects);
+    std::vector<int> packed;
+    int stride = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        py::sequence rect = py::cast<py::sequence>(items[i]);
+        if (stride == 0) {
+            stride = (int) rect.size();
+        }
+        if ((stride != 4 && stride != 8) || (int) rect.size() != stride) {
+            throw py::value_error("DrawImageBatch rectangles must all have 4 or all have 8 values");
+        }
+        for (int j = 0; j < stride; j++) {
+            packed.push_back(py::cast<int>(rect[j]));
+        }
+    }
+    if (stride != 0) {
+        engine.DrawImageBatch(imgPath, packed.data(), (int) packed.size() / stride, stride);
+    }
+}
+
 // Creates a macro function that will be called
 // whenever the module is imported into python
 // 'tinyengine' is what we 'import' into python.
@@ -644,32 +1848,120 @@ namespace py = pybind11;
 PYBIND11_MODULE(tinyengine, m){
     m.doc() = "The TinyEngine is python bindings for common SDL functions";
 
+    // Key codes, so hot loops can check keys without looking up their names.
+    for (int i = 0; i < KeyNames::COUNT; i++) {
+        m.attr(KeyNames::at(i).constant) = (int) KeyNames::at(i).scancode;
+    }
+    // The types of the events PollEvents returns.
+    m.attr("EVENT_KEY_DOWN") = (int) INPUT_KEY_DOWN;
+    m.attr("EVENT_KEY_UP") = (int) INPUT_KEY_UP;
+    m.attr("EVENT_MOUSE_MOTION") = (int) INPUT_MOUSE_MOTION;
+    m.attr("EVENT_MOUSE_DOWN") = (int) INPUT_MOUSE_DOWN;
+    m.attr("EVENT_MOUSE_UP") = (int) INPUT_MOUSE_UP;
+    m.attr("EVENT_MOUSE_WHEEL") = (int) INPUT_MOUSE_WHEEL;
+    m.attr("EVENT_CONTROLLER_AXIS") = (int) INPUT_CONTROLLER_AXIS;
+    m.attr("EVENT_CONTROLLER_DOWN") = (int) INPUT_CONTROLLER_DOWN;
+    m.attr("EVENT_CONTROLLER_UP") = (int) INPUT_CONTROLLER_UP;
+
+    py::class_<PreloadProgress, std::shared_ptr<PreloadProgress>>(m, "PreloadProgress")
+            .def("IsDone", &PreloadProgress::isDone)
+            .def("GetProgress", &PreloadProgress::getProgress)
+            .def_readonly("total", &PreloadProgress::total)
+            .def_readonly("loaded", &PreloadProgress::loaded)
+            .def_readonly("failed", &PreloadProgress::failed);
+
     py::class_<GameEngine>(m, "GameEngine")
-            .def(py::init<int,int,std::string>(), py::arg("w"), py::arg("h"), py::arg("title"))   // our constructor
+            .def(py::init<int,int,std::string,std::string,bool>(), py::arg("w"), py::arg("h"), py::arg("title"),
+                py::arg("backend") = "sdl", py::arg("headless") = false)   // our constructor
             .def("clear", &GameEngine::clear) // Expose member methods
             .def("flip", &GameEngine::flip)
             .def("delay", &GameEngine::delay)
-            .def("pressed", &GameEngine::pressed)
+            .def("pressed", py::overload_cast<int>(&GameEngine::pressed))
+            .def("pressed", py::overload_cast<std::string>(&GameEngine::pressed))
+            .def("PollInput", &GameEngine::PollInput)
+            .def("JustPressed", py::overload_cast<int>(&GameEngine::JustPressed))
+            .def("JustPressed", py::overload_cast<std::string>(&GameEngine::JustPressed))
+            .def("JustReleased", py::overload_cast<int>(&GameEngine::JustReleased))
+            .def("JustReleased", py::overload_cast<std::string>(&GameEngine::JustReleased))
+            .def("LatchInput", &GameEngine::LatchInput)
+            .def("GetInputLatency", &GameEngine::GetInputLatency)
+            .def("GetInputLatencyPercentile", &GameEngine::GetInputLatencyPercentile)
+            .def("QuitRequested", &GameEngine::QuitRequested)
+            .def("SubscribeEvents", &GameEngine::SubscribeEvents, py::arg("types"), py::arg("subscribe") = true)
+            .def("PollEvents", [](GameEngine& engine) {
+                // Packed as (timestamp, type, code, x, y, device) in struct format "=IHHhhi".
+                const std::vector<InputEvent>& events = engine.PollEvents();
+                return py::bytes(reinterpret_cast<const char*>(events.data()), events.size() * sizeof(InputEvent));
+            })
+            .def("GetDroppedEvents", &GameEngine::GetDroppedEvents)
+            .def("StartRecording", &GameEngine::StartRecording)
+            .def("StopRecording", &GameEngine::StopRecording)
+            .def("StartReplay", &GameEngine::StartReplay)
+            .def("IsReplaying", &GameEngine::IsReplaying)
+            .def("Run", &GameEngine::Run, py::arg("update"), py::arg("render"), py::arg("hz"),
+                py::arg("maxSteps") = 5)
+            .def("Stop", &GameEngine::Stop)
+            .def("GetDroppedSteps", &GameEngine::GetDroppedSteps)
             .def("DrawRectangle", &GameEngine::DrawRectangle)
-            .def("DrawImage", &GameEngine::DrawImage)
-            .def("DrawFrame", &GameEngine::DrawFrame)
+            .def("DrawImage", py::overload_cast<std::string, int, int, int, int>(&GameEngine::DrawImage))
+            .def("DrawImage", py::overload_cast<int, int, int, int, int>(&GameEngine::DrawImage))
+            .def("DrawImageBatch", &drawImageBatch<std::string>, py::arg("imgPath"), py::arg("rects"))
+            .def("DrawImageBatch", &drawImageBatch<int>, py::arg("texture"), py::arg("rects"))
+            .def("DrawFrame", py::overload_cast<std::string, int, int, int, int, int, int>(&GameEngine::DrawFrame))
+            .def("DrawFrame", py::overload_cast<int, int, int, int, int, int, int>(&GameEngine::DrawFrame))
             .def("SetColor", &GameEngine::SetColor)
             .def("PlayMusic", &GameEngine::PlayMusic)
-            .def("PlaySFX", &GameEngine::PlaySFX)
+            .def("PlaySFX", py::overload_cast<std::string>(&GameEngine::PlaySFX))
+            .def("PlaySFX", py::overload_cast<int>(&GameEngine::PlaySFX))
+            .def("LoadTexture", &GameEngine::LoadTexture)
+            .def("LoadSound", &GameEngine::LoadSound)
+            .def("LoadFont", &GameEngine::LoadFont)
             .def("ToggleMusic", &GameEngine::ToggleMusic)
             .def("SetMusicVolume", &GameEngine::SetMusicVolume)
             .def("GetMusicVolume", &GameEngine::GetMusicVolume)
-            .def("RenderText", &GameEngine::RenderText)
-            .def("RenderCenteredText", &GameEngine::RenderCenteredText)
+            .def("RenderText", py::overload_cast<std::string, std::string, int, int, int>(&GameEngine::RenderText))
+            .def("RenderText", py::overload_cast<std::string, int, int, int>(&GameEngine::RenderText))
+            .def("RenderCenteredText", py::overload_cast<std::string, std::string, int, int>(&GameEngine::RenderCenteredText))
+            .def("RenderCenteredText", py::overload_cast<std::string, int, int>(&GameEngine::RenderCenteredText))
             .def("FrameRateDelay", &GameEngine::ApplyFrameCap)
             .def("SetFramerate", &GameEngine::SetFramerate)
+            .def("GetFrameTime", &GameEngine::GetFrameTime)
+            .def("GetDeltaTime", &GameEngine::GetDeltaTime)
+            .def("GetFrameTimePercentile", &GameEngine::GetFrameTimePercentile)
+            .def("GetJitterPercentile", &GameEngine::GetJitterPercentile)
             .def("RectIntersect", &GameEngine::RectIntersect)
             .def("SetTextColor", &GameEngine::SetTextColor)
+            .def("SetTextCaching", &GameEngine::SetTextCaching)
+            .def("GetFontMemoryUsage", &GameEngine::GetFontMemoryUsage)
             .def("DrawLine", &GameEngine::DrawLine)
             .def("DrawLines", &GameEngine::DrawLines)
             .def("LineIntersect", &GameEngine::LineIntersect)
             .def("ShapeIntersect", &GameEngine::ShapeIntersect)
-            .def("SetBackgroundColor", &GameEngine::SetBackgroundColor);
+            .def("SetBackgroundColor", &GameEngine::SetBackgroundColor)
+            .def("SetBatching", &GameEngine::SetBatching)
+            .def("GetDrawCallsSubmitted", &GameEngine::GetDrawCallsSubmitted)
+            .def("GetDrawCallsSaved", &GameEngine::GetDrawCallsSaved)
+            .def("SetSortByTexture", &GameEngine::SetSortByTexture)
+            .def("IsHeadless", &GameEngine::IsHeadless)
+            .def("SetRenderingEnabled", &GameEngine::SetRenderingEnabled)
+            .def("SetAtlasEnabled", &GameEngine::SetAtlasEnabled)
+            .def("SetAtlasPageSize", &GameEngine::SetAtlasPageSize)
+            .def("GetAtlasStats", &GameEngine::GetAtlasStats)
+            .def("Preload", &GameEngine::Preload)
+            .def("SetPreloadBudget", &GameEngine::SetPreloadBudget)
+            .def("LoadAssetPack", &GameEngine::LoadAssetPack)
+            .def("SetCacheBudget", &GameEngine::SetCacheBudget)
+            .def("GetCacheStats", &GameEngine::GetCacheStats)
+            .def("PinResource", &GameEngine::PinResource)
+            .def("UnpinResource", &GameEngine::UnpinResource)
+            .def("GetDedupStats", &GameEngine::GetDedupStats)
+            .def("SetMipmapsEnabled", &GameEngine::SetMipmapsEnabled)
+            .def("SetTextureFormat", &GameEngine::SetTextureFormat)
+            .def("GetImageSize", &GameEngine::GetImageSize)
+            .def("WatchResources", &GameEngine::WatchResources);
+
+    m.def("CookAssetPack", &AssetCooker::cook, py::arg("resources"), py::arg("output"),
+        "Writes the given resource files into an asset pack for GameEngine.LoadAssetPack");
 }
 
 #endif
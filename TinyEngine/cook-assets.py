@@ -0,0 +1,28 @@
+# Builds an asset pack from a resources directory, so games can start without
+# decoding their images and sound effects. Load it with engine.LoadAssetPack.
+#
+# Run with: python3 cook-assets.py [directory] [output]
+# which defaults to: python3 cook-assets.py resources resources.pack
+
+import os
+import sys
+
+# Sound effects are decoded with the mixer, which doesn't need a sound card.
+os.environ.setdefault("SDL_AUDIODRIVER", "dummy")
+
+import tinyengine
+
+directory = sys.argv[1] if len(sys.argv) > 1 else "resources"
+output = sys.argv[2] if len(sys.argv) > 2 else "resources.pack"
+
+# Games look resources up by the paths they pass to the engine, like
+# "resources/space-invaders/hit.mp3", so those are the paths stored.
+paths = []
+for root, dirs, files in os.walk(directory):
+    dirs.sort()
+    for name in sorted(files):
+        paths.append(os.path.join(root, name).replace(os.sep, "/"))
+
+if not tinyengine.CookAssetPack(paths, output):
+    sys.exit(1)
+print("Packed {} files into {}".format(len(paths), output))
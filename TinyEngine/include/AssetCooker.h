@@ -0,0 +1,163 @@
+#ifndef ASSET_COOKER_H
+#define ASSET_COOKER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "AssetPack.h"
+#include "ResourceManager.h"
+#include "SFXManager.h"
+
+/** Builds asset packs. Images are decoded and converted to ARGB8888, the format SDL
+	renderers prefer, with the green screen turned into alpha. Short sounds are
+	decoded to the mixer's format. Everything else is stored as is. */
+class AssetCooker {
+public:
+	/** Audio files up to this size are also stored decoded, for playing as sound effects.
+		Longer ones are likely music, which streams from the original bytes. The same
+		cut-off ResourceManager::preload uses. */
+	static const Sint64 MAX_DECODED_AUDIO = ResourceManager::MAX_DECODED_AUDIO;
+
+	/** Writes the given resources into a pack. They are looked up by the same paths at
+		runtime. Returns false if the pack could not be written. */
+	static bool cook(/** The resource paths */ const std::vector<std::string>& resources,
+		/** The pack file to write */ const std::string& output) {
+		AssetCooker cooker;
+		// Sound effects are decoded to whatever format the mixer plays.
+		SFXManager::instance();
+		int frequency = 0;
+		Uint16 format = 0;
+		int channels = 0;
+		bool mixerOpen = Mix_QuerySpec(&frequency, &format, &channels) != 0;
+
+		for (size_t i = 0; i < resources.size(); i++) {
+			const std::string& resource = resources[i];
+			ResourceManager::PreloadType type = ResourceManager::typeOf(resource);
+
+			std::vector<char> bytes;
+			if (!ResourceManager::readFile(resource, bytes)) {
+				SDL_Log("Could not read %s", resource.c_str());
+				return false;
+			}
+
+			if (type == ResourceManager::PRELOAD_IMAGE && cooker.addImage(resource)) {
+				continue;
+			}
+			if (type == ResourceManager::PRELOAD_SOUND && mixerOpen && (Sint64) bytes.size() <= MAX_DECODED_AUDIO) {
+				Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(bytes.data(), (int) bytes.size()), 1);
+				if (chunk != NULL) {
+					AssetPackEntry& entry = cooker.add(resource, PACK_PCM, chunk->abuf, chunk->alen);
+					entry.format = format;
+					entry.width = (Uint32) frequency;
+					entry.height = (Uint32) channels;
+					Mix_FreeChunk(chunk);
+				}
+			}
+			cooker.add(resource, PACK_FILE, bytes.data(), bytes.size());
+		}
+
+		if (!cooker.write(output)) {
+			SDL_Log("Could not write asset pack %s", output.c_str());
+			return false;
+		}
+		SDL_Log("Cooked %d resources into %s", (int) resources.size(), output.c_str());
+		return true;
+	}
+
+private:
+	/** Decodes and converts an image. Returns false if it isn't one SDL_image can read. */
+	bool addImage(const std::string& resource) {
+		SDL_Surface* image = ResourceManager::decodeImage(resource);
+		if (image == NULL) {
+			return false;
+		}
+		// Converting to a format with alpha turns the color key into transparent pixels.
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(image);
+		if (converted == NULL) {
+			return false;
+		}
+		AssetPackEntry& entry = add(resource, PACK_IMAGE, converted->pixels, (size_t) converted->pitch * converted->h);
+		entry.format = SDL_PIXELFORMAT_ARGB8888;
+		entry.width = (Uint32) converted->w;
+		entry.height = (Uint32) converted->h;
+		entry.pitch = (Uint32) converted->pitch;
+		SDL_FreeSurface(converted);
+		return true;
+	}
+
+	/** Adds an entry holding a copy of the given data */
+	AssetPackEntry& add(const std::string& resource, Uint32 kind, const void* data, size_t size) {
+		AssetPackEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.kind = kind;
+		entry.nameOffset = (Uint32) names.size();
+		entry.nameLength = (Uint32) resource.size();
+		entry.size = size;
+		names += resource;
+
+		const Uint8* bytes = static_cast<const Uint8*>(data);
+		blobs.push_back(std::vector<Uint8>(bytes, bytes + size));
+		entries.push_back(entry);
+		return entries.back();
+	}
+
+	/** Lays out and writes the pack */
+	bool write(const std::string& output) {
+		AssetPackHeader header;
+		memcpy(header.magic, "TEPK", 4);
+		header.version = AssetPack::VERSION;
+		header.count = (Uint32) entries.size();
+		header.namesSize = (Uint32) names.size();
+
+		Uint64 offset = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + names.size();
+		for (size_t i = 0; i < entries.size(); i++) {
+			offset = align(offset);
+			entries[i].offset = offset;
+			offset += entries[i].size;
+		}
+
+		SDL_RWops* out = SDL_RWFromFile(output.c_str(), "wb");
+		if (out == NULL) {
+			return false;
+		}
+		bool ok = SDL_RWwrite(out, &header, sizeof(header), 1) == 1;
+		if (!entries.empty()) {
+			ok = ok && SDL_RWwrite(out, entries.data(), sizeof(AssetPackEntry), entries.size()) == entries.size();
+		}
+		if (!names.empty()) {
+			ok = ok && SDL_RWwrite(out, names.data(), names.size(), 1) == 1;
+		}
+
+		Uint64 written = sizeof(header) + entries.size() * sizeof(AssetPackEntry) + names.size();
+		const Uint8 padding[AssetPack::ALIGNMENT] = { 0 };
+		for (size_t i = 0; i < entries.size() && ok; i++) {
+			size_t gap = (size_t) (entries[i].offset - written);
+			if (gap > 0) {
+				ok = SDL_RWwrite(out, padding, gap, 1) == 1;
+			}
+			if (ok && !blobs[i].empty()) {
+				ok = SDL_RWwrite(out, blobs[i].data(), blobs[i].size(), 1) == 1;
+			}
+			written = entries[i].offset + entries[i].size;
+		}
+		return SDL_RWclose(out) == 0 && ok;
+	}
+
+	/** Rounds an offset up to the data alignment */
+	static Uint64 align(Uint64 offset) {
+		return (offset + AssetPack::ALIGNMENT - 1) / AssetPack::ALIGNMENT * AssetPack::ALIGNMENT;
+	}
+
+	/** The index being built */
+	std::vector<AssetPackEntry> entries;
+	/** The data of each entry */
+	std::vector<std::vector<Uint8>> blobs;
+	/** Every entry's resource path, back to back */
+	std::string names;
+};
+
+#endif
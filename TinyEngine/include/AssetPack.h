@@ -0,0 +1,110 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <SDL2/SDL.h>
+#include <map>
+#include <string>
+#include <utility>
+
+/** What an asset pack entry holds */
+enum AssetPackKind {
+	/** Pixels already converted to the entry's format, with transparency baked into alpha */
+	PACK_IMAGE = 1,
+	/** Sound samples already decoded to the mixer's output format */
+	PACK_PCM = 2,
+	/** The original file's bytes, for music, fonts and anything else */
+	PACK_FILE = 3
+};
+
+/** The start of an asset pack file. The index entries follow it, then their names,
+	then the data. */
+struct AssetPackHeader {
+	/** Always "TEPK" */
+	char magic[4];
+	/** The pack format version */
+	Uint32 version;
+	/** The number of index entries */
+	Uint32 count;
+	/** The bytes of entry names following the index */
+	Uint32 namesSize;
+};
+
+/** One entry of an asset pack's index */
+struct AssetPackEntry {
+	/** An AssetPackKind */
+	Uint32 kind;
+	/** Where the resource path starts, relative to the names */
+	Uint32 nameOffset;
+	/** The length of the resource path */
+	Uint32 nameLength;
+	/** The SDL pixel format of an image, or the SDL audio format of samples */
+	Uint32 format;
+	/** The width of an image, or the sample rate of samples */
+	Uint32 width;
+	/** The height of an image, or the channel count of samples */
+	Uint32 height;
+	/** The bytes per row of an image */
+	Uint32 pitch;
+	/** Unused, keeps the offsets 8 byte aligned */
+	Uint32 reserved;
+	/** Where the data starts, relative to the start of the file */
+	Uint64 offset;
+	/** The bytes of data */
+	Uint64 size;
+};
+
+/** A read-only asset pack, memory mapped so resources are used straight from the file
+	without reading or decoding them. Built by AssetCooker. */
+class AssetPack {
+public:
+	/** The pack format version this code reads and writes */
+	static const Uint32 VERSION = 1;
+	/** Data blocks start on multiples of this many bytes */
+	static const Uint32 ALIGNMENT = 16;
+
+	/** Creates a pack with nothing open */
+	AssetPack() {}
+
+	/** Unmaps the pack. Nothing loaded from it may be used afterwards. */
+	~AssetPack() {
+		close();
+	}
+
+	/** Maps the pack at the given path and reads its index. Returns false if it is missing or damaged. */
+	bool open(/** The pack file */ const std::string& path);
+
+	/** Unmaps the pack */
+	void close();
+
+	/** Returns the entry of the given kind for a resource, or NULL if the pack doesn't have one */
+	const AssetPackEntry* find(/** The resource path */ const std::string& resource,
+		/** An AssetPackKind */ Uint32 kind) const {
+		auto found = index.find(std::make_pair(resource, kind));
+		return found != index.end() ? found->second : NULL;
+	}
+
+	/** Returns the data of an entry */
+	const Uint8* data(const AssetPackEntry& entry) const {
+		return bytes + entry.offset;
+	}
+
+private:
+	AssetPack(const AssetPack&);
+	AssetPack& operator=(const AssetPack&);
+
+	/** Checks the header and entries fit in the file and describe their data correctly, then indexes the entries */
+	bool readIndex();
+
+	/** The mapped file */
+	const Uint8* bytes = NULL;
+	/** The size of the mapped file */
+	size_t length = 0;
+	/** The platform's handle for the open file, if it needs one */
+	void* file = NULL;
+	/** The platform's handle for the mapping, if it needs one */
+	void* mapping = NULL;
+	/** Entries by resource path and kind */
+	std::map<std::pair<std::string, Uint32>, const AssetPackEntry*> index;
+};
+
+#endif
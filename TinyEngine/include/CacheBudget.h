@@ -0,0 +1,239 @@
+#ifndef CACHE_BUDGET_H
+#define CACHE_BUDGET_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+#include <atomic>
+#include <deque>
+#include <map>
+
+/** Keeps a cache under a memory budget by tracking how big each entry is and how
+	recently it was used. The cache itself stays with its owner, which frees whatever
+	nextVictim picks. Pinned entries and the entry being added are never picked.
+	Uses are recorded as timestamps rather than by reordering a list. Each key keeps its
+	timestamp in a slot that is never freed, so threads can record uses through touch
+	without any lock, even while entries are being added and evicted. */
+template <typename Key>
+class CacheBudget {
+public:
+	/** Where a key's uses are recorded, and how many times it has come and gone */
+	struct Slot {
+		/** The tick the key was last used at */
+		std::atomic<Uint64> lastUsed{0};
+		/** Changes whenever the key is added anew or removed, so anything remembering
+			what was cached under it can tell, without a lock, whether it still is */
+		std::atomic<Uint32> version{0};
+	};
+
+	/** Sets the most bytes the cache should hold, or 0 for no limit */
+	void setBudget(/** The budget in bytes */ size_t bytes) {
+		budget = bytes;
+	}
+
+	/** Records a lookup that found key in the cache. Safe to call from several threads
+		at once, as long as none of them calls anything else meanwhile. */
+	void hit(const Key& key) {
+		hits.fetch_add(1, std::memory_order_relaxed);
+		auto found = entries.find(key);
+		if (found != entries.end()) {
+			found->second.slot->lastUsed.store(tick(), std::memory_order_relaxed);
+		}
+	}
+
+	/** Records a lookup that had to load key, which now takes up the given bytes */
+	void add(const Key& key, /** The entry's size */ size_t size) {
+		misses.fetch_add(1, std::memory_order_relaxed);
+		Entry& entry = entries[key];
+		if (entry.slot == NULL) {
+			entry.slot = slotFor(key);
+			entry.slot->version.fetch_add(1, std::memory_order_release);
+		}
+		bytes += size - entry.size;
+		entry.size = size;
+		entry.slot->lastUsed.store(tick(), std::memory_order_relaxed);
+	}
+
+	/** Returns where uses of key are recorded, or NULL if it was never added. The slot
+		outlives the entry, so it can be kept and passed to touch after key is evicted. */
+	Slot* findSlot(const Key& key) const {
+		auto found = slots.find(key);
+		return found != slots.end() ? found->second : NULL;
+	}
+
+	/** Records a use through a slot from findSlot, without looking the entry up. Safe to
+		call from any thread at any time. Uses are stamped with the time of the last
+		add or resize rather than a new one, and the stamp is only written if that
+		changed, so threads sharing an entry rarely write to the same cache line. The
+		order is only approximate: a touched entry ties with the last one added. */
+	void touch(Slot* slot) const {
+		Uint64 now = clock.load(std::memory_order_relaxed);
+		if (slot->lastUsed.load(std::memory_order_relaxed) != now) {
+			slot->lastUsed.store(now, std::memory_order_relaxed);
+		}
+	}
+
+	/** Changes key's version without removing it, for when what is cached under it was
+		replaced in place */
+	void invalidate(const Key& key) {
+		Slot* slot = findSlot(key);
+		if (slot != NULL) {
+			slot->version.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+	/** Adds lookups that found their entry but were counted elsewhere, as with touch */
+	void addHits(int count) {
+		hits.fetch_add(count, std::memory_order_relaxed);
+	}
+
+	/** Changes how many bytes an entry that was just used takes up, without counting a lookup */
+	void resize(const Key& key, /** The entry's new size */ size_t size) {
+		auto found = entries.find(key);
+		if (found != entries.end()) {
+			bytes += size - found->second.size;
+			found->second.size = size;
+			found->second.slot->lastUsed.store(tick(), std::memory_order_relaxed);
+		}
+	}
+
+	/** Finds the least recently used entry that should go to get back under budget.
+		Returns false if the cache is within budget or nothing can be evicted. */
+	bool nextVictim(/** Receives the entry to evict */ Key& victim,
+		/** The entry being added, which must stay */ const Key& keep) const {
+		return nextVictim(victim, keep, [](const Key&) { return false; });
+	}
+
+	/** nextVictim, also passing over entries busy says are still in use */
+	template <typename Busy>
+	bool nextVictim(/** Receives the entry to evict */ Key& victim,
+		/** The entry being added, which must stay */ const Key& keep,
+		/** Returns whether an entry is in use and must stay */ Busy busy) const {
+		if (budget == 0 || bytes <= budget) {
+			return false;
+		}
+		auto oldest = entries.end();
+		for (auto it = entries.begin(); it != entries.end(); ++it) {
+			if (it->first != keep && pins.count(it->first) == 0 && (oldest == entries.end() || stamp(it) < stamp(oldest))
+				&& !busy(it->first)) {
+				oldest = it;
+			}
+		}
+		if (oldest == entries.end()) {
+			return false;
+		}
+		victim = oldest->first;
+		return true;
+	}
+
+	/** Records that the owner freed an entry picked by nextVictim */
+	void evicted(const Key& key) {
+		evictions++;
+		remove(key);
+	}
+
+	/** Forgets an entry the owner freed for some other reason */
+	void remove(const Key& key) {
+		auto found = entries.find(key);
+		if (found != entries.end()) {
+			bytes -= found->second.size;
+			found->second.slot->version.fetch_add(1, std::memory_order_release);
+			entries.erase(found);
+		}
+	}
+
+	/** Keeps an entry from being evicted until it is unpinned as many times. May be
+		called before the entry is loaded. */
+	void pin(const Key& key) {
+		pins[key]++;
+	}
+
+	/** Undoes one pin */
+	void unpin(const Key& key) {
+		auto found = pins.find(key);
+		if (found != pins.end() && --found->second <= 0) {
+			pins.erase(found);
+		}
+	}
+
+	/** The budget in bytes, or 0 for no limit */
+	size_t getBudget() const {
+		return budget;
+	}
+
+	/** The bytes held by the cache */
+	size_t getBytes() const {
+		return bytes;
+	}
+
+	/** The number of entries in the cache */
+	int getEntries() const {
+		return (int) entries.size();
+	}
+
+	/** Lookups that found their entry */
+	int getHits() const {
+		return hits.load(std::memory_order_relaxed);
+	}
+
+	/** Lookups that had to load their entry */
+	int getMisses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+
+	/** Entries freed to stay under budget */
+	int getEvictions() const {
+		return evictions;
+	}
+
+private:
+	/** An entry's size and when it was last used */
+	struct Entry {
+		/** The bytes the entry takes up */
+		size_t size = 0;
+		/** Its key's slot */
+		Slot* slot = NULL;
+	};
+
+	/** Returns a time later than any returned before */
+	Uint64 tick() {
+		return clock.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+	/** Returns when an entry was last used */
+	static Uint64 stamp(typename std::map<Key, Entry>::const_iterator entry) {
+		return entry->second.slot->lastUsed.load(std::memory_order_relaxed);
+	}
+
+	/** Returns key's slot, creating it the first time */
+	Slot* slotFor(const Key& key) {
+		auto found = slots.find(key);
+		if (found != slots.end()) {
+			return found->second;
+		}
+		stamps.emplace_back();
+		return slots.insert(std::make_pair(key, &stamps.back())).first->second;
+	}
+
+	/** Every entry by key */
+	std::map<Key, Entry> entries;
+	/** The slot of every key ever added. Never shrinks, so slots stay where they are. */
+	std::map<Key, Slot*> slots;
+	/** The slots themselves. A deque never moves what it already holds as it grows. */
+	std::deque<Slot> stamps;
+	/** How many times each pinned key is pinned */
+	std::map<Key, int> pins;
+	/** Counts uses, to order them */
+	std::atomic<Uint64> clock{0};
+	/** The budget in bytes, or 0 for no limit */
+	size_t budget = 0;
+	/** The bytes held by the cache */
+	size_t bytes = 0;
+	/** Lookups that found their entry */
+	std::atomic<int> hits{0};
+	/** Lookups that had to load their entry */
+	std::atomic<int> misses{0};
+	/** Entries freed to stay under budget */
+	int evictions = 0;
+};
+
+#endif
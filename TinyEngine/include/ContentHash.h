@@ -0,0 +1,104 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <SDL2/SDL.h>
+#include <string.h>
+
+/** Hashes file contents with XXH64, so identical resources can be found without
+	comparing them byte by byte. */
+class ContentHash {
+public:
+	/** Returns the XXH64 hash of the given bytes */
+	static Uint64 hash(/** The bytes */ const void* data, /** How many */ size_t length,
+		/** Starts different families of hashes */ Uint64 seed = 0) {
+		const Uint8* p = static_cast<const Uint8*>(data);
+		const Uint8* end = p + length;
+		Uint64 h;
+
+		if (length >= 32) {
+			Uint64 v1 = seed + PRIME1 + PRIME2;
+			Uint64 v2 = seed + PRIME2;
+			Uint64 v3 = seed;
+			Uint64 v4 = seed - PRIME1;
+			const Uint8* limit = end - 32;
+			do {
+				v1 = round(v1, read64(p));
+				v2 = round(v2, read64(p + 8));
+				v3 = round(v3, read64(p + 16));
+				v4 = round(v4, read64(p + 24));
+				p += 32;
+			} while (p <= limit);
+
+			h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+			h = merge(h, v1);
+			h = merge(h, v2);
+			h = merge(h, v3);
+			h = merge(h, v4);
+		} else {
+			h = seed + PRIME5;
+		}
+		h += (Uint64) length;
+
+		for (; p + 8 <= end; p += 8) {
+			h ^= round(0, read64(p));
+			h = rotl(h, 27) * PRIME1 + PRIME4;
+		}
+		if (p + 4 <= end) {
+			h ^= (Uint64) read32(p) * PRIME1;
+			h = rotl(h, 23) * PRIME2 + PRIME3;
+			p += 4;
+		}
+		for (; p < end; p++) {
+			h ^= *p * PRIME5;
+			h = rotl(h, 11) * PRIME1;
+		}
+
+		h ^= h >> 33;
+		h *= PRIME2;
+		h ^= h >> 29;
+		h *= PRIME3;
+		h ^= h >> 32;
+		return h;
+	}
+
+private:
+	/** The XXH64 constants */
+	static const Uint64 PRIME1 = 0x9E3779B185EBCA87ULL;
+	static const Uint64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+	static const Uint64 PRIME3 = 0x165667B19E3779F9ULL;
+	static const Uint64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+	static const Uint64 PRIME5 = 0x27D4EB2F165667C5ULL;
+
+	/** Rotates x left by r bits */
+	static Uint64 rotl(Uint64 x, int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	/** Mixes 8 bytes of input into an accumulator */
+	static Uint64 round(Uint64 acc, Uint64 input) {
+		acc += input * PRIME2;
+		return rotl(acc, 31) * PRIME1;
+	}
+
+	/** Folds an accumulator into the hash */
+	static Uint64 merge(Uint64 acc, Uint64 v) {
+		acc ^= round(0, v);
+		return acc * PRIME1 + PRIME4;
+	}
+
+	/** Reads 8 bytes little endian, as XXH64 is defined */
+	static Uint64 read64(const Uint8* p) {
+		Uint64 v;
+		memcpy(&v, p, sizeof(v));
+		return SDL_SwapLE64(v);
+	}
+
+	/** Reads 4 bytes little endian */
+	static Uint32 read32(const Uint8* p) {
+		Uint32 v;
+		memcpy(&v, p, sizeof(v));
+		return SDL_SwapLE32(v);
+	}
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef DRAW_COMMAND_BUFFER_H
+#define DRAW_COMMAND_BUFFER_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+/** Records the rectangles, lines and color changes of a frame and submits
+	runs of the same primitive and color with a single SDL call. */
+class DrawCommandBuffer {
+public:
+	/** Sets the color used by the following primitives */
+	void setColor(/** The new draw color */ SDL_Color color) {
+		currentColor = color;
+		recordedCalls++;
+	}
+
+	/** Records a filled rectangle */
+	void fillRect(/** The rectangle to fill */ const SDL_Rect& rect) {
+		push(FILL_RECT, rect.x, rect.y, rect.w, rect.h);
+	}
+
+	/** Records a wireframe rectangle */
+	void drawRect(/** The rectangle to outline */ const SDL_Rect& rect) {
+		push(DRAW_RECT, rect.x, rect.y, rect.w, rect.h);
+	}
+
+	/** Records a line from (x1, y1) to (x2, y2) */
+	void drawLine(int x1, int y1, int x2, int y2) {
+		push(DRAW_LINE, x1, y1, x2, y2);
+	}
+
+	/** Counts a primitive or color change drawn straight away, with batching off */
+	void countImmediate() {
+		recordedCalls++;
+		submittedCalls++;
+	}
+
+	/** Drops any pending commands and starts a new frame. The renderer's draw color
+		must already be the given color (as it is right after clearing the screen). */
+	void reset(/** The renderer's current draw color */ SDL_Color rendererColor) {
+		commands.clear();
+		currentColor = rendererColor;
+		submittedColor = rendererColor;
+		recordedCalls = 0;
+		submittedCalls = 0;
+	}
+
+	/** Submits every pending command to the renderer, merging consecutive commands
+		of the same type and color into SDL_RenderFillRects, SDL_RenderDrawRects
+		or SDL_RenderDrawLines calls. */
+	void flush(/** The renderer to draw with */ SDL_Renderer* ren) {
+		size_t i = 0;
+		while (i < commands.size()) {
+			const Command& first = commands[i];
+			size_t end = i + 1;
+			while (end < commands.size() && commands[end].type == first.type
+				&& sameColor(commands[end].color, first.color)) {
+				end++;
+			}
+
+			if (!sameColor(submittedColor, first.color)) {
+				SDL_SetRenderDrawColor(ren, first.color.r, first.color.g, first.color.b, first.color.a);
+				submittedColor = first.color;
+				submittedCalls++;
+			}
+
+			if (first.type == DRAW_LINE) {
+				submitLines(ren, i, end);
+			} else {
+				rects.clear();
+				for (size_t j = i; j < end; j++) {
+					const Command& c = commands[j];
+					SDL_Rect rect = { c.a, c.b, c.c, c.d };
+					rects.push_back(rect);
+				}
+				if (first.type == FILL_RECT) {
+					SDL_RenderFillRects(ren, rects.data(), (int) rects.size());
+				} else {
+					SDL_RenderDrawRects(ren, rects.data(), (int) rects.size());
+				}
+				submittedCalls++;
+			}
+			i = end;
+		}
+		commands.clear();
+
+		// Leave the renderer in the state immediate mode would have left it in.
+		if (!sameColor(submittedColor, currentColor)) {
+			SDL_SetRenderDrawColor(ren, currentColor.r, currentColor.g, currentColor.b, currentColor.a);
+			submittedColor = currentColor;
+			submittedCalls++;
+		}
+	}
+
+	/** The number of SDL calls immediate mode would have made since the last reset */
+	int getRecordedCalls() const {
+		return recordedCalls;
+	}
+
+	/** The number of SDL calls actually made since the last reset */
+	int getSubmittedCalls() const {
+		return submittedCalls;
+	}
+
+private:
+	/** The kinds of primitives that can be recorded */
+	enum CommandType { FILL_RECT, DRAW_RECT, DRAW_LINE };
+
+	/** A recorded primitive. Rectangles store x, y, w, h and lines store x1, y1, x2, y2. */
+	struct Command {
+		CommandType type;
+		SDL_Color color;
+		int a, b, c, d;
+	};
+
+	static bool sameColor(SDL_Color x, SDL_Color y) {
+		return x.r == y.r && x.g == y.g && x.b == y.b && x.a == y.a;
+	}
+
+	void push(CommandType type, int a, int b, int c, int d) {
+		Command command = { type, currentColor, a, b, c, d };
+		commands.push_back(command);
+		recordedCalls++;
+	}
+
+	/** Submits the lines in [begin, end) as polylines, starting a new polyline
+		whenever a segment does not continue from the previous one. */
+	void submitLines(SDL_Renderer* ren, size_t begin, size_t end) {
+		points.clear();
+		for (size_t j = begin; j < end; j++) {
+			const Command& c = commands[j];
+			bool continues = !points.empty() && points.back().x == c.a && points.back().y == c.b;
+			if (!continues) {
+				if (points.size() > 1) {
+					SDL_RenderDrawLines(ren, points.data(), (int) points.size());
+					submittedCalls++;
+				}
+				points.clear();
+				SDL_Point start = { c.a, c.b };
+				points.push_back(start);
+			}
+			SDL_Point next = { c.c, c.d };
+			points.push_back(next);
+		}
+		if (points.size() > 1) {
+			SDL_RenderDrawLines(ren, points.data(), (int) points.size());
+			submittedCalls++;
+		}
+	}
+
+	/** The commands recorded since the last flush */
+	std::vector<Command> commands;
+	/** Scratch storage for merged rectangles */
+	std::vector<SDL_Rect> rects;
+	/** Scratch storage for merged polylines */
+	std::vector<SDL_Point> points;
+
+	/** The color the next recorded primitive will use */
+	SDL_Color currentColor = { 255, 255, 255, 255 };
+	/** The draw color the renderer currently has */
+	SDL_Color submittedColor = { 255, 255, 255, 255 };
+
+	/** SDL calls immediate mode would have made this frame */
+	int recordedCalls = 0;
+	/** SDL calls made this frame */
+	int submittedCalls = 0;
+};
+
+#endif
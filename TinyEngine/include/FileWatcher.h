@@ -0,0 +1,64 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** Watches directories for files that are written, on a background thread.
+	Only supported on Linux, where it uses inotify; elsewhere watch returns false. */
+class FileWatcher {
+public:
+	/** Creates a watcher watching nothing */
+	FileWatcher() {}
+
+	/** Stops the background thread */
+	~FileWatcher() {
+		stop();
+	}
+
+	/** Watches a directory and everything under it, including directories created later.
+		Returns false if it can't be watched. */
+	bool watch(/** The directory, as resource paths under it start */ const std::string& directory);
+
+	/** Returns the paths of files written since the last call, each once */
+	std::vector<std::string> takeChanged() {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<std::string> paths(changed.begin(), changed.end());
+		changed.clear();
+		return paths;
+	}
+
+private:
+	FileWatcher(const FileWatcher&);
+	FileWatcher& operator=(const FileWatcher&);
+
+	/** Watches a directory and its subdirectories, returning false if the directory
+		itself can't be watched. Call with mutex held. */
+	bool addWatches(const std::string& directory);
+
+	/** Collects changed files until stopped. Runs on the background thread. */
+	void run();
+
+	/** Stops the background thread and closes the watch */
+	void stop();
+
+	/** The platform's handle for the watch, or -1 */
+	int fd = -1;
+	/** Reads changes from fd */
+	std::thread thread;
+	/** Cleared to stop the thread */
+	std::atomic<bool> running{false};
+	/** Guards changed and directories, which both threads use */
+	std::mutex mutex;
+	/** Files written since the last takeChanged */
+	std::set<std::string> changed;
+	/** The path of each watched directory by its watch descriptor */
+	std::map<int, std::string> directories;
+};
+
+#endif
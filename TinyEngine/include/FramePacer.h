@@ -0,0 +1,161 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/** Paces frames to a target rate using the high resolution performance counter.
+	Most of the wait is spent sleeping; the last couple of milliseconds are spun
+	so the OS scheduler's granularity doesn't show up as stutter. Deadlines advance
+	by exactly one period each frame, so rounding never accumulates into drift. */
+class FramePacer {
+public:
+	/** How many recent frames the statistics cover */
+	static const int HISTORY = 240;
+
+	/** Creates a pacer for 60 frames per second */
+	FramePacer() : frequency((double) SDL_GetPerformanceFrequency()) {
+		setFramerate(60);
+		history.reserve(HISTORY);
+	}
+
+	/** Sets the target framerate */
+	void setFramerate(/** Frames per second */ int fps) {
+		period = fps > 0 ? frequency / fps : 0;
+		deadline = 0;
+	}
+
+	/** Chooses whether to pump SDL's events while sleeping, so input that arrives
+		during the wait is seen, and timestamped, as it arrives. Pumping has to happen
+		on the thread that created the window. */
+	void setPumpEvents(/** Whether to pump events */ bool pump) {
+		pumpEvents = pump;
+	}
+
+	/** Sets how long before a deadline to stop sleeping and start spinning */
+	void setSpinMargin(/** The margin in milliseconds */ double ms) {
+		spinMargin = ms;
+	}
+
+	/** Waits until the current frame's deadline, then starts the next frame */
+	void wait() {
+		double now = (double) SDL_GetPerformanceCounter();
+		if (deadline == 0) {
+			deadline = now + period;
+		}
+
+		double remainingMs = (deadline - now) * 1000.0 / frequency;
+		if (pumpEvents) {
+			// Sleep a millisecond at a time, pumping events in between.
+			while (remainingMs > spinMargin) {
+				SDL_PumpEvents();
+				SDL_Delay(1);
+				remainingMs = (deadline - (double) SDL_GetPerformanceCounter()) * 1000.0 / frequency;
+			}
+		} else if (remainingMs > spinMargin) {
+			SDL_Delay((Uint32) (remainingMs - spinMargin));
+		}
+		while ((double) SDL_GetPerformanceCounter() < deadline) {
+			// Spin out the last moments for an accurate wake up.
+		}
+
+		now = (double) SDL_GetPerformanceCounter();
+		deadline += period;
+		// After a long stall, start over instead of rushing frames out to catch up.
+		if (now > deadline) {
+			deadline = now + period;
+		}
+		record(now);
+	}
+
+	/** Starts the next frame without waiting, still recording frame times */
+	void tick() {
+		record((double) SDL_GetPerformanceCounter());
+	}
+
+	/** The length of the last frame in milliseconds */
+	double getFrameTime() const {
+		return lastFrameTime;
+	}
+
+	/** The length of the last frame in seconds, for scaling movement */
+	double getDeltaTime() const {
+		return lastFrameTime / 1000.0;
+	}
+
+	/** The given percentile (0 to 100) of recent frame times, in milliseconds */
+	double getFrameTimePercentile(double percentile) {
+		scratch = history;
+		return percentileOf(scratch, percentile);
+	}
+
+	/** The given percentile (0 to 100) of how far recent frame times strayed from their mean, in milliseconds */
+	double getJitterPercentile(double percentile) {
+		if (history.empty()) {
+			return 0;
+		}
+		double mean = 0;
+		for (auto it = history.begin(); it != history.end(); ++it) {
+			mean += *it;
+		}
+		mean /= history.size();
+
+		scratch.clear();
+		for (auto it = history.begin(); it != history.end(); ++it) {
+			scratch.push_back(std::fabs(*it - mean));
+		}
+		return percentileOf(scratch, percentile);
+	}
+
+	/** Returns the given percentile of values, reordering them */
+	static double percentileOf(std::vector<double>& values, double percentile) {
+		if (values.empty()) {
+			return 0;
+		}
+		percentile = std::min(100.0, std::max(0.0, percentile));
+		size_t index = (size_t) std::lround(percentile / 100.0 * (values.size() - 1));
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+private:
+	/** Records the end of a frame */
+	void record(double now) {
+		if (lastFrameEnd != 0) {
+			lastFrameTime = (now - lastFrameEnd) * 1000.0 / frequency;
+			if ((int) history.size() < HISTORY) {
+				history.push_back(lastFrameTime);
+			} else {
+				history[next] = lastFrameTime;
+			}
+			next = (next + 1) % HISTORY;
+		}
+		lastFrameEnd = now;
+	}
+
+	/** Performance counter ticks per second */
+	double frequency;
+	/** Performance counter ticks per frame, or 0 for no cap */
+	double period = 0;
+	/** When the current frame should end, in performance counter ticks */
+	double deadline = 0;
+	/** Milliseconds before the deadline to stop sleeping */
+	double spinMargin = 2.0;
+	/** Whether to pump events while sleeping */
+	bool pumpEvents = false;
+
+	/** When the last frame ended, in performance counter ticks */
+	double lastFrameEnd = 0;
+	/** The length of the last frame in milliseconds */
+	double lastFrameTime = 0;
+	/** Recent frame times in milliseconds, as a ring buffer */
+	std::vector<double> history;
+	/** Where the next frame time goes in history */
+	int next = 0;
+	/** Scratch space for computing percentiles */
+	std::vector<double> scratch;
+};
+
+#endif
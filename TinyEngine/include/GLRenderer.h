@@ -0,0 +1,607 @@
+#ifndef GL_RENDERER_H
+#define GL_RENDERER_H
+
+#include <SDL2/SDL.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ResourceManager.h"
+#include "GlyphAtlas.h"
+
+/** An image uploaded to OpenGL */
+struct GLTexture {
+	/** The OpenGL texture name */
+	GLuint id;
+	/** The width of the image */
+	int w;
+	/** The height of the image */
+	int h;
+	/** The number of mip levels below the full image */
+	int levels;
+};
+
+/** Draws the engine's primitives with OpenGL 3.3 core. A frame's geometry is
+	collected on the CPU, grouped into batches that share a texture and submitted
+	from one streaming vertex buffer with a single shader program. */
+class GLRenderer {
+public:
+	/** Creates an OpenGL context for the window. Check isReady() afterwards. */
+	GLRenderer(/** A window created with SDL_WINDOW_OPENGL */ SDL_Window* w,
+		/** The width of the window */ int width, /** The height of the window */ int height)
+		: window(w), screenWidth(width), screenHeight(height) {
+		context = SDL_GL_CreateContext(window);
+		if (context == NULL) {
+			SDL_Log("OpenGL context could not be created! SDL Error: %s", SDL_GetError());
+			return;
+		}
+		if (!gladLoadGLLoader((GLADloadproc) SDL_GL_GetProcAddress)) {
+			SDL_Log("Failed to load OpenGL functions");
+			return;
+		}
+		if (GLVersion.major < 3 || (GLVersion.major == 3 && GLVersion.minor < 3)) {
+			SDL_Log("OpenGL 3.3 is required, found %d.%d", GLVersion.major, GLVersion.minor);
+			return;
+		}
+		SDL_GL_SetSwapInterval(0);
+
+		program = createProgram();
+		if (program == 0) {
+			return;
+		}
+		screenUniform = glGetUniformLocation(program, "screen");
+
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, x));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, u));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*) offsetof(Vertex, color));
+
+		// Untextured primitives sample a single white texel, so everything shares one shader.
+		Uint32 white = 0xFFFFFFFF;
+		whiteTexture = createTexture(1, 1, &white);
+
+		glViewport(0, 0, screenWidth, screenHeight);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		ready = true;
+	}
+
+	/** Frees every OpenGL object and the context */
+	~GLRenderer() {
+		if (context == NULL) {
+			return;
+		}
+		for (auto it = textures.begin(); it != textures.end(); ++it) {
+			glDeleteTextures(1, &it->second.id);
+		}
+		if (!retired.empty()) {
+			glDeleteTextures((GLsizei) retired.size(), retired.data());
+		}
+		for (auto it = glyphTextures.begin(); it != glyphTextures.end(); ++it) {
+			glDeleteTextures(1, &it->second.texture.id);
+		}
+		if (ready) {
+			glDeleteTextures(1, &whiteTexture);
+			glDeleteBuffers(1, &vbo);
+			glDeleteVertexArrays(1, &vao);
+			glDeleteProgram(program);
+		}
+		SDL_GL_DeleteContext(context);
+	}
+
+	/** Whether the context was created and the renderer can draw */
+	bool isReady() const {
+		return ready;
+	}
+
+	/** Drops any pending geometry and clears the screen to the given color */
+	void clear(SDL_Color color) {
+		items.clear();
+		vertices.clear();
+		drawCalls = 0;
+		primitives = 0;
+		glClearColor(color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+
+	/** Draws the pending geometry and shows the frame */
+	void present() {
+		flush();
+		// Textures freed this frame may still have been drawn in it.
+		if (!retired.empty()) {
+			glDeleteTextures((GLsizei) retired.size(), retired.data());
+			retired.clear();
+		}
+		lastFrameDrawCalls = drawCalls;
+		lastFramePrimitives = primitives;
+		SDL_GL_SwapWindow(window);
+	}
+
+	/** Draws a filled rectangle */
+	void fillRect(const SDL_Rect& rect, SDL_Color color) {
+		primitives++;
+		addQuad(whiteTexture, (float) rect.x, (float) rect.y, (float) (rect.x + rect.w),
+			(float) (rect.y + rect.h), 0, 0, 1, 1, color);
+	}
+
+	/** Draws the outline of a rectangle */
+	void drawRect(const SDL_Rect& rect, SDL_Color color) {
+		float x0 = rect.x + 0.5f, y0 = rect.y + 0.5f;
+		float x1 = rect.x + rect.w - 0.5f, y1 = rect.y + rect.h - 0.5f;
+		primitives++;
+		addLine(x0, y0, x1, y0, color);
+		addLine(x1, y0, x1, y1, color);
+		addLine(x1, y1, x0, y1, color);
+		addLine(x0, y1, x0, y0, color);
+	}
+
+	/** Draws a line between the centers of two pixels */
+	void drawLine(float x1, float y1, float x2, float y2, SDL_Color color) {
+		primitives++;
+		addLine(x1 + 0.5f, y1 + 0.5f, x2 + 0.5f, y2 + 0.5f, color);
+	}
+
+	/** Returns the given image as a texture, loading it the first time. Textures are
+		kept under the ResourceManager's path for the image, so copies share one, and
+		count against its texture budget, so the least recently used are freed to stay
+		under it and pinned images are kept. The texture may be freed once stamp is no
+		longer current. */
+	const GLTexture* getTexture(/** The image path */ const std::string& path,
+		/** Receives the stamp of the texture, if not NULL */ ResourceStamp* stamp = NULL) {
+		ResourceManager& resources = ResourceManager::instance();
+		std::string owner;
+		bool counted = resources.findExternalTexture(path, owner, stamp);
+		auto found = textures.find(owner);
+		if (found != textures.end()) {
+			if (counted) {
+				return &found->second;
+			}
+			// Evicted since, so it is loaded afresh.
+			retire(found);
+		}
+
+		SDL_Surface* image = resources.loadImage(owner);
+		if (image == NULL) {
+			return NULL;
+		}
+		SDL_Surface* rgba = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(image);
+		if (rgba == NULL) {
+			SDL_Log("Failed to convert surface for OpenGL");
+			return NULL;
+		}
+		GLTexture texture = { createTexture(rgba->w, rgba->h, rgba->pixels, rgba->pitch / 4), rgba->w, rgba->h, 0 };
+		if (mipmaps) {
+			texture.levels = uploadMips(rgba);
+		}
+		std::vector<std::string> evicted;
+		resources.trackExternalTexture(owner, rgba->w, rgba->h, 4, evicted, stamp);
+		SDL_FreeSurface(rgba);
+		for (size_t i = 0; i < evicted.size(); i++) {
+			auto victim = textures.find(evicted[i]);
+			if (victim != textures.end()) {
+				retire(victim);
+			}
+		}
+		return &textures.insert(std::make_pair(owner, texture)).first->second;
+	}
+
+	/** Replaces the pixels of an image's texture with a reloaded copy of the image, if
+		the image has been loaded. The texture keeps its name, so draws already holding
+		it show the new pixels. Call between frames. */
+	void reloadTexture(/** The image path */ const std::string& path, /** The new image */ SDL_Surface* image) {
+		auto found = textures.find(path);
+		if (found == textures.end()) {
+			return;
+		}
+		SDL_Surface* rgba = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+		if (rgba == NULL) {
+			SDL_Log("Failed to convert surface for OpenGL");
+			return;
+		}
+		glBindTexture(GL_TEXTURE_2D, found->second.id);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, rgba->pitch / 4);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rgba->w, rgba->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba->pixels);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		found->second.w = rgba->w;
+		found->second.h = rgba->h;
+		if (found->second.levels > 0) {
+			found->second.levels = uploadMips(rgba);
+		}
+		SDL_FreeSurface(rgba);
+	}
+
+	/** Draws part of a texture, or all of it if src is NULL, into dst */
+	void drawTexture(const GLTexture* texture, const SDL_Rect* src, const SDL_Rect& dst) {
+		if (texture == NULL) {
+			return;
+		}
+		float u0 = 0, v0 = 0, u1 = 1, v1 = 1;
+		if (src != NULL) {
+			u0 = (float) src->x / texture->w;
+			v0 = (float) src->y / texture->h;
+			u1 = (float) (src->x + src->w) / texture->w;
+			v1 = (float) (src->y + src->h) / texture->h;
+		}
+		SDL_Color white = { 255, 255, 255, 255 };
+		primitives++;
+		addQuad(texture->id, (float) dst.x, (float) dst.y, (float) (dst.x + dst.w), (float) (dst.y + dst.h),
+			u0, v0, u1, v1, white);
+	}
+
+	/** Draws glyph quads laid out by a glyph atlas, tinted with color */
+	void drawText(GlyphAtlas* atlas, const std::vector<GlyphQuad>& quads, SDL_Color color) {
+		const GLTexture* texture = getGlyphTexture(atlas);
+		primitives += (int) quads.size();
+		for (auto it = quads.begin(); it != quads.end(); ++it) {
+			float u0 = (float) it->src.x / texture->w, v0 = (float) it->src.y / texture->h;
+			float u1 = (float) (it->src.x + it->src.w) / texture->w, v1 = (float) (it->src.y + it->src.h) / texture->h;
+			addQuad(texture->id, (float) it->dst.x, (float) it->dst.y, (float) (it->dst.x + it->dst.w),
+				(float) (it->dst.y + it->dst.h), u0, v0, u1, v1, color);
+		}
+	}
+
+	/** When on, the default, images loaded from now on get mipmaps, so drawing them at
+		half size or less samples a smaller, smoothed copy */
+	void setMipmapsEnabled(bool enabled) {
+		mipmaps = enabled;
+	}
+
+	/** When on, each frame's geometry is reordered so everything using the same texture
+		is drawn together. This gives the fewest draw calls, but overlapping primitives
+		with different textures may then be drawn in a different order. */
+	void setSortByTexture(bool enabled) {
+		sortByTexture = enabled;
+	}
+
+	/** The number of draw calls made during the last frame */
+	int getDrawCalls() const {
+		return lastFrameDrawCalls;
+	}
+
+	/** The number of rectangles, lines, images and glyphs drawn during the last frame:
+		the draw calls it would have taken to draw each on its own */
+	int getPrimitives() const {
+		return lastFramePrimitives;
+	}
+
+private:
+	/** One vertex of the stream */
+	struct Vertex {
+		float x, y;
+		float u, v;
+		Uint8 color[4];
+	};
+
+	/** A run of vertices that can be drawn with one call */
+	struct Batch {
+		GLenum mode;
+		GLuint texture;
+		int first;
+		int count;
+	};
+
+	/** A glyph atlas uploaded to OpenGL */
+	struct GlyphTexture {
+		GLTexture texture;
+		int version;
+	};
+
+	static bool sameState(const Batch& a, const Batch& b) {
+		return a.mode == b.mode && a.texture == b.texture;
+	}
+
+	static bool stateLess(const Batch& a, const Batch& b) {
+		return a.mode < b.mode || (a.mode == b.mode && a.texture < b.texture);
+	}
+
+	/** Appends vertices to the frame, extending the last batch if it has the same state */
+	void addVertices(GLenum mode, GLuint texture, const Vertex* v, int count) {
+		Batch batch = { mode, texture, (int) vertices.size(), count };
+		if (!items.empty() && sameState(items.back(), batch)) {
+			items.back().count += count;
+		} else {
+			items.push_back(batch);
+		}
+		vertices.insert(vertices.end(), v, v + count);
+	}
+
+	void addQuad(GLuint texture, float x0, float y0, float x1, float y1,
+		float u0, float v0, float u1, float v1, SDL_Color c) {
+		Vertex quad[6] = {
+			{ x0, y0, u0, v0, { c.r, c.g, c.b, c.a } },
+			{ x1, y0, u1, v0, { c.r, c.g, c.b, c.a } },
+			{ x1, y1, u1, v1, { c.r, c.g, c.b, c.a } },
+			{ x1, y1, u1, v1, { c.r, c.g, c.b, c.a } },
+			{ x0, y1, u0, v1, { c.r, c.g, c.b, c.a } },
+			{ x0, y0, u0, v0, { c.r, c.g, c.b, c.a } }
+		};
+		addVertices(GL_TRIANGLES, texture, quad, 6);
+	}
+
+	void addLine(float x0, float y0, float x1, float y1, SDL_Color c) {
+		Vertex line[2] = {
+			{ x0, y0, 0, 0, { c.r, c.g, c.b, c.a } },
+			{ x1, y1, 1, 1, { c.r, c.g, c.b, c.a } }
+		};
+		addVertices(GL_LINES, whiteTexture, line, 2);
+	}
+
+	/** Copies the frame's vertices into the stream buffer and issues one draw per batch */
+	void flush() {
+		if (items.empty()) {
+			return;
+		}
+
+		const std::vector<Batch>* order = &items;
+		if (sortByTexture) {
+			sorted = items;
+			std::stable_sort(sorted.begin(), sorted.end(), stateLess);
+			order = &sorted;
+		}
+
+		// The buffer is written front to back without synchronizing, since the GPU never
+		// reads a range written this frame before it is drawn. Once full it is orphaned,
+		// letting the driver hand over fresh storage while earlier frames finish.
+		GLsizeiptr bytes = (GLsizeiptr) (vertices.size() * sizeof(Vertex));
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		if (bytes > capacity) {
+			while (capacity < bytes) {
+				capacity *= 2;
+			}
+			glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+			offset = 0;
+		} else if (offset + bytes > capacity) {
+			glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+			offset = 0;
+		}
+
+		Vertex* mapped = (Vertex*) glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (mapped == NULL) {
+			SDL_Log("Failed to map the OpenGL vertex buffer");
+			items.clear();
+			vertices.clear();
+			return;
+		}
+
+		draws.clear();
+		int base = (int) (offset / (GLintptr) sizeof(Vertex));
+		int written = 0;
+		for (auto it = order->begin(); it != order->end(); ++it) {
+			memcpy(mapped + written, &vertices[it->first], it->count * sizeof(Vertex));
+			Batch draw = { it->mode, it->texture, base + written, it->count };
+			if (!draws.empty() && sameState(draws.back(), draw)) {
+				draws.back().count += it->count;
+			} else {
+				draws.push_back(draw);
+			}
+			written += it->count;
+		}
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		offset += bytes;
+
+		glUseProgram(program);
+		glUniform2f(screenUniform, (float) screenWidth, (float) screenHeight);
+		glActiveTexture(GL_TEXTURE0);
+		GLuint bound = 0;
+		for (auto it = draws.begin(); it != draws.end(); ++it) {
+			if (it->texture != bound) {
+				glBindTexture(GL_TEXTURE_2D, it->texture);
+				bound = it->texture;
+			}
+			glDrawArrays(it->mode, it->first, it->count);
+			drawCalls++;
+		}
+
+		items.clear();
+		vertices.clear();
+	}
+
+	/** Returns the texture for a glyph atlas, uploading it again if glyphs were added */
+	const GLTexture* getGlyphTexture(GlyphAtlas* atlas) {
+		SDL_Surface* surface = atlas->getSurface();
+		auto found = glyphTextures.find(atlas);
+		if (found == glyphTextures.end()) {
+			GlyphTexture created = { { createTexture(surface->w, surface->h, NULL), surface->w, surface->h, 0 }, -1 };
+			found = glyphTextures.insert(std::make_pair(atlas, created)).first;
+		}
+		if (found->second.version != atlas->getVersion()) {
+			// Glyphs already queued this frame must be drawn before their texture changes.
+			flush();
+			glBindTexture(GL_TEXTURE_2D, found->second.texture.id);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, surface->pitch / 4);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surface->w, surface->h, GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+			found->second.version = atlas->getVersion();
+		}
+		return &found->second.texture;
+	}
+
+	/** Creates an RGBA texture from tightly packed pixels (or uninitialized if pixels is NULL) */
+	GLuint createTexture(int w, int h, const void* pixels, int rowLength = 0) {
+		GLuint id;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		return id;
+	}
+
+	/** Forgets an image's texture, deleting it once the current frame is shown */
+	void retire(std::map<std::string, GLTexture>::iterator texture) {
+		retired.push_back(texture->second.id);
+		textures.erase(texture);
+	}
+
+	/** Uploads the mip levels of an image to the bound texture, which holds the full
+		image, and samples the nearest level from then on. Returns the number of levels. */
+	int uploadMips(SDL_Surface* rgba) {
+		int levels = MipChain::levels(rgba->w, rgba->h);
+		SDL_Surface* level = rgba;
+		for (int i = 1; i <= levels; i++) {
+			// Built by hand rather than with glGenerateMipmap, which would blend in the
+			// color of transparent pixels.
+			SDL_Surface* half = MipChain::halve(level);
+			if (level != rgba) {
+				SDL_FreeSurface(level);
+			}
+			level = half;
+			if (level == NULL) {
+				levels = i - 1;
+				break;
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, level->pitch / 4);
+			glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, level->w, level->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, level->pixels);
+		}
+		if (level != rgba) {
+			SDL_FreeSurface(level);
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 0 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+		return levels;
+	}
+
+	/** Compiles one shader stage, returning 0 on failure */
+	static GLuint compileShader(GLenum type, const char* source) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (compiled != GL_TRUE) {
+			char log[512];
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			SDL_Log("Shader could not be compiled: %s", log);
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+
+	/** Builds the one shader program everything is drawn with, returning 0 on failure */
+	static GLuint createProgram() {
+		const char* vertexSource =
+			"#version 330 core\n"
+			"layout(location = 0) in vec2 position;\n"
+			"layout(location = 1) in vec2 texCoord;\n"
+			"layout(location = 2) in vec4 color;\n"
+			"uniform vec2 screen;\n"
+			"out vec2 fragTexCoord;\n"
+			"out vec4 fragColor;\n"
+			"void main() {\n"
+			"    vec2 ndc = position / screen * 2.0 - 1.0;\n"
+			"    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);\n"
+			"    fragTexCoord = texCoord;\n"
+			"    fragColor = color;\n"
+			"}\n";
+		const char* fragmentSource =
+			"#version 330 core\n"
+			"in vec2 fragTexCoord;\n"
+			"in vec4 fragColor;\n"
+			"uniform sampler2D image;\n"
+			"out vec4 outColor;\n"
+			"void main() {\n"
+			"    outColor = texture(image, fragTexCoord) * fragColor;\n"
+			"}\n";
+
+		GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+		GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+		if (vertexShader == 0 || fragmentShader == 0) {
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (linked != GL_TRUE) {
+			char log[512];
+			glGetProgramInfoLog(program, sizeof(log), NULL, log);
+			SDL_Log("Shader program could not be linked: %s", log);
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	/** The window being drawn to */
+	SDL_Window* window;
+	/** The OpenGL context */
+	SDL_GLContext context = NULL;
+	/** Whether setup succeeded */
+	bool ready = false;
+	/** The width of the window */
+	int screenWidth;
+	/** The height of the window */
+	int screenHeight;
+
+	/** The shader program */
+	GLuint program = 0;
+	/** The location of the screen size uniform */
+	GLint screenUniform = -1;
+	/** The vertex layout */
+	GLuint vao = 0;
+	/** The streaming vertex buffer */
+	GLuint vbo = 0;
+	/** The size of the vertex buffer in bytes */
+	GLsizeiptr capacity = 1 << 22;
+	/** Where the next frame's vertices go in the vertex buffer */
+	GLintptr offset = 0;
+	/** A single white texel for untextured primitives */
+	GLuint whiteTexture = 0;
+
+	/** Whether new image textures get mipmaps */
+	bool mipmaps = true;
+	/** Images by the ResourceManager's path for them */
+	std::map<std::string, GLTexture> textures;
+	/** Textures of evicted images, deleted once the frame that may draw them is shown */
+	std::vector<GLuint> retired;
+	/** Uploaded glyph atlases */
+	std::map<GlyphAtlas*, GlyphTexture> glyphTextures;
+
+	/** Vertices queued this frame */
+	std::vector<Vertex> vertices;
+	/** Batches queued this frame, in submission order */
+	std::vector<Batch> items;
+	/** Scratch copy of items sorted by texture */
+	std::vector<Batch> sorted;
+	/** Scratch list of draw calls */
+	std::vector<Batch> draws;
+
+	/** Whether batches are reordered by texture */
+	bool sortByTexture = false;
+	/** Draw calls made so far this frame */
+	int drawCalls = 0;
+	/** Draw calls made during the last frame */
+	int lastFrameDrawCalls = 0;
+	/** Primitives drawn so far this frame */
+	int primitives = 0;
+	/** Primitives drawn during the last frame */
+	int lastFramePrimitives = 0;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <string>
+#include <vector>
+
+#include "SkylinePacker.h"
+
+/** Where to copy one glyph from the atlas to draw a string */
+struct GlyphQuad {
+	/** The glyph's rectangle in the atlas */
+	SDL_Rect src;
+	/** Where the glyph goes on screen */
+	SDL_Rect dst;
+};
+
+/** Caches the glyphs of one font at one size in a single texture, so text can be
+	drawn as a batch of quads without rendering surfaces each frame.
+	Glyphs are rasterized in white the first time they are used; the text color is
+	applied when drawing. */
+class GlyphAtlas {
+public:
+	/** Creates an empty atlas for the given font */
+	GlyphAtlas(/** The font to rasterize glyphs from */ TTF_Font* f) : font(f) {
+		// Leave room for a few hundred glyphs; the atlas restarts if it ever fills up.
+		int height = TTF_FontHeight(font);
+		size = 256;
+		while (size < 2048 && size * size < height * height * 256) {
+			size *= 2;
+		}
+		surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA32);
+		restart();
+	}
+
+	/** Frees the atlas surface and texture */
+	~GlyphAtlas() {
+		SDL_FreeSurface(surface);
+		if (texture != NULL) {
+			SDL_DestroyTexture(texture);
+		}
+	}
+
+	/** Appends a quad for every glyph of text drawn with its upper left corner at (x, y).
+		Returns the width of the text. */
+	int layout(/** Latin-1 text */ const std::string& text, int x, int y,
+		/** Receives the quads */ std::vector<GlyphQuad>& quads) {
+		if (!cacheGlyphs(text)) {
+			restart();
+			cacheGlyphs(text);
+		}
+
+		int pen = 0;
+		Uint16 previous = 0;
+		for (size_t i = 0; i < text.size(); i++) {
+			Uint16 ch = (unsigned char) text[i];
+			const Glyph& glyph = glyphs[ch];
+			if (!glyph.cached) {
+				continue;
+			}
+			if (previous != 0) {
+				pen += TTF_GetFontKerningSizeGlyphs(font, previous, ch);
+			}
+			if (glyph.rect.w > 0) {
+				GlyphQuad quad = { glyph.rect, { x + pen, y, glyph.rect.w, glyph.rect.h } };
+				quads.push_back(quad);
+			}
+			pen += glyph.advance;
+			previous = ch;
+		}
+		return pen;
+	}
+
+	/** Returns the width text would have when drawn */
+	int measure(/** Latin-1 text */ const std::string& text) {
+		scratch.clear();
+		return layout(text, 0, 0, scratch);
+	}
+
+	/** Switches to another font, such as a reloaded copy of the same one, dropping every glyph */
+	void setFont(/** The font to rasterize glyphs from */ TTF_Font* f) {
+		font = f;
+		restart();
+	}
+
+	/** Returns the atlas pixels, white glyphs on a transparent background */
+	SDL_Surface* getSurface() {
+		return surface;
+	}
+
+	/** Returns a number that changes whenever the atlas pixels change */
+	int getVersion() const {
+		return version;
+	}
+
+	/** Returns the atlas as a texture for the given renderer, uploading any glyphs added since the last call */
+	SDL_Texture* getTexture(/** The renderer to draw with */ SDL_Renderer* ren) {
+		if (texture == NULL) {
+			texture = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, size, size);
+			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+			uploadedVersion = -1;
+		}
+		if (uploadedVersion != version) {
+			SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
+			uploadedVersion = version;
+		}
+		return texture;
+	}
+
+	/** Returns the bytes of pixel memory held by the atlas */
+	size_t getMemoryUsage() const {
+		return (size_t) size * size * 4 * (texture != NULL ? 2 : 1);
+	}
+
+private:
+	/** A cached glyph */
+	struct Glyph {
+		/** Whether the glyph has been rasterized since the last restart */
+		bool cached;
+		/** The glyph's cell in the atlas (empty for blank glyphs such as spaces) */
+		SDL_Rect rect;
+		/** How far the pen moves after the glyph */
+		int advance;
+	};
+
+	/** Drops every glyph and clears the atlas */
+	void restart() {
+		for (int i = 0; i < 256; i++) {
+			glyphs[i].cached = false;
+		}
+		packer = SkylinePacker(size, size);
+		SDL_FillRect(surface, NULL, 0);
+		version++;
+	}
+
+	/** Rasterizes any glyph of text not in the atlas yet. Returns false if the atlas is full. */
+	bool cacheGlyphs(const std::string& text) {
+		for (size_t i = 0; i < text.size(); i++) {
+			Uint16 ch = (unsigned char) text[i];
+			if (!glyphs[ch].cached && !cacheGlyph(ch)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Rasterizes one glyph into the atlas */
+	bool cacheGlyph(Uint16 ch) {
+		Glyph& glyph = glyphs[ch];
+		glyph.rect = { 0, 0, 0, 0 };
+		glyph.advance = 0;
+
+		int minx, maxx, miny, maxy;
+		if (ch == 0 || TTF_GlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &glyph.advance) != 0) {
+			// Unknown glyphs take up no space, as they would in TTF_RenderText.
+			glyph.cached = true;
+			return true;
+		}
+
+		// Rendering the glyph as a one character string places it in its cell exactly
+		// as a full line of text would.
+		char single[2] = { (char) ch, '\0' };
+		SDL_Color white = { 255, 255, 255, 255 };
+		SDL_Surface* rendered = TTF_RenderText_Blended(font, single, white);
+		if (rendered != NULL && ch != ' ') {
+			SDL_Point position;
+			if (!packer.insert(rendered->w + 1, rendered->h + 1, position)) {
+				SDL_FreeSurface(rendered);
+				return false;
+			}
+			glyph.rect = { position.x, position.y, rendered->w, rendered->h };
+			SDL_SetSurfaceBlendMode(rendered, SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(rendered, NULL, surface, &glyph.rect);
+			glyph.rect.w = rendered->w;
+			glyph.rect.h = rendered->h;
+			version++;
+		}
+		SDL_FreeSurface(rendered);
+
+		glyph.cached = true;
+		return true;
+	}
+
+	/** The font glyphs are rasterized from */
+	TTF_Font* font;
+	/** The width and height of the atlas */
+	int size;
+	/** The atlas pixels */
+	SDL_Surface* surface;
+	/** Allocates cells for new glyphs */
+	SkylinePacker packer = SkylinePacker(0, 0);
+	/** Every Latin-1 glyph, indexed by character */
+	Glyph glyphs[256];
+	/** Changes whenever the atlas pixels change */
+	int version = 0;
+
+	/** The atlas uploaded for rendering */
+	SDL_Texture* texture = NULL;
+	/** The version of the atlas last uploaded to the texture */
+	int uploadedVersion = -1;
+	/** Scratch quads for measuring text */
+	std::vector<GlyphQuad> scratch;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef IMAGE_HEADER_H
+#define IMAGE_HEADER_H
+
+#include <SDL2/SDL.h>
+#include <string.h>
+#include <string>
+
+/** Reads the width and height of PNG and JPEG files from their headers, without
+	decoding any pixels. */
+class ImageHeader {
+public:
+	/** Reads the size of the image at the given path. Returns false if it isn't a PNG
+		or JPEG, or the header is damaged. */
+	static bool readSize(/** The image path */ const std::string& resource, /** Receives the size */ SDL_Point& size) {
+		SDL_RWops* rw = SDL_RWFromFile(resource.c_str(), "rb");
+		if (rw == NULL) {
+			return false;
+		}
+		bool found = readSize(rw, size);
+		SDL_RWclose(rw);
+		return found;
+	}
+
+	/** Reads the size of an image from the start of a stream */
+	static bool readSize(SDL_RWops* rw, SDL_Point& size) {
+		Uint8 signature[8];
+		if (SDL_RWread(rw, signature, sizeof(signature), 1) != 1) {
+			return false;
+		}
+		static const Uint8 PNG[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		if (memcmp(signature, PNG, sizeof(PNG)) == 0) {
+			return readPNG(rw, size);
+		}
+		if (signature[0] == 0xFF && signature[1] == 0xD8) {
+			SDL_RWseek(rw, 2, RW_SEEK_SET);
+			return readJPEG(rw, size);
+		}
+		return false;
+	}
+
+private:
+	/** Reads the IHDR chunk, which always comes first */
+	static bool readPNG(SDL_RWops* rw, SDL_Point& size) {
+		Uint8 chunk[16];
+		if (SDL_RWread(rw, chunk, sizeof(chunk), 1) != 1 || memcmp(chunk + 4, "IHDR", 4) != 0) {
+			return false;
+		}
+		size.x = (int) readBE32(chunk + 8);
+		size.y = (int) readBE32(chunk + 12);
+		return size.x > 0 && size.y > 0;
+	}
+
+	/** Skips segments until a start of frame marker, which holds the size */
+	static bool readJPEG(SDL_RWops* rw, SDL_Point& size) {
+		while (true) {
+			Uint8 marker[4];
+			if (SDL_RWread(rw, marker, sizeof(marker), 1) != 1 || marker[0] != 0xFF) {
+				return false;
+			}
+			// Markers may be padded with any number of 0xFF bytes.
+			while (marker[1] == 0xFF) {
+				marker[1] = marker[2];
+				marker[2] = marker[3];
+				if (SDL_RWread(rw, marker + 3, 1, 1) != 1) {
+					return false;
+				}
+			}
+			int length = (marker[2] << 8) | marker[3];
+			if (length < 2) {
+				return false;
+			}
+			// SOF0 to SOF15, except DHT (C4), JPG (C8) and DAC (CC), which share the range.
+			Uint8 type = marker[1];
+			if (type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC) {
+				Uint8 frame[5];
+				if (SDL_RWread(rw, frame, sizeof(frame), 1) != 1) {
+					return false;
+				}
+				size.y = (frame[1] << 8) | frame[2];
+				size.x = (frame[3] << 8) | frame[4];
+				return size.x > 0 && size.y > 0;
+			}
+			if (type == 0xD9 || type == 0xDA) {
+				// The end of the image, or the pixels, came before any frame header.
+				return false;
+			}
+			if (SDL_RWseek(rw, length - 2, RW_SEEK_CUR) < 0) {
+				return false;
+			}
+		}
+	}
+
+	/** Reads a big endian 32 bit number */
+	static Uint32 readBE32(const Uint8* p) {
+		return ((Uint32) p[0] << 24) | ((Uint32) p[1] << 16) | ((Uint32) p[2] << 8) | p[3];
+	}
+};
+
+#endif
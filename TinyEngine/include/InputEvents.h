@@ -0,0 +1,190 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <SDL2/SDL.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+/** The kinds of input event */
+enum InputEventType {
+	/** A key went down. code is its scancode and x is 1 if it is repeating. */
+	INPUT_KEY_DOWN = 1,
+	/** A key came up. code is its scancode. */
+	INPUT_KEY_UP = 2,
+	/** The mouse moved to (x, y) in the window */
+	INPUT_MOUSE_MOTION = 3,
+	/** A mouse button went down at (x, y). code is the button. */
+	INPUT_MOUSE_DOWN = 4,
+	/** A mouse button came up at (x, y). code is the button. */
+	INPUT_MOUSE_UP = 5,
+	/** The mouse wheel scrolled by (x, y) */
+	INPUT_MOUSE_WHEEL = 6,
+	/** A controller axis moved to x. code is the SDL_GameControllerAxis. */
+	INPUT_CONTROLLER_AXIS = 7,
+	/** A controller button went down. code is the SDL_GameControllerButton. */
+	INPUT_CONTROLLER_DOWN = 8,
+	/** A controller button came up. code is the SDL_GameControllerButton. */
+	INPUT_CONTROLLER_UP = 9
+};
+
+/** An input event packed into 16 bytes */
+struct InputEvent {
+	/** When SDL queued it, in milliseconds since SDL started */
+	Uint32 timestamp;
+	/** An InputEventType */
+	Uint16 type;
+	/** The key, button or axis */
+	Uint16 code;
+	/** The x position, scroll amount or axis value */
+	Sint16 x;
+	/** The y position or scroll amount */
+	Sint16 y;
+	/** The mouse or controller it came from */
+	Sint32 device;
+};
+
+static_assert(sizeof(InputEvent) == 16, "InputEvent should pack into 16 bytes");
+
+/** Keeps the input events a game has asked for in a ring buffer, in place of SDL's
+	event queue. SDL hands every event to filter as it is queued, while holding its
+	own lock, so there is only ever one producer; the game's thread drains the events
+	as the one consumer. Input events nobody asked for are dropped there, which SDL
+	allows since it has already updated its keyboard and mouse state by then. */
+class InputEventQueue {
+public:
+	/** The most events held between drains. Further events are dropped. */
+	static const Uint32 CAPACITY = 1024;
+
+	/** Returns the type with the given name, such as "key_down", or 0 if there is none */
+	static int typeOf(const std::string& name) {
+		static const char* NAMES[] = { "key_down", "key_up", "mouse_motion", "mouse_down", "mouse_up",
+			"mouse_wheel", "controller_axis", "controller_down", "controller_up" };
+		for (int i = 0; i < (int) (sizeof(NAMES) / sizeof(NAMES[0])); i++) {
+			if (name == NAMES[i]) {
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+
+	/** Starts or stops keeping events of a type */
+	void subscribe(/** An InputEventType */ int type, /** Whether to keep its events */ bool keep) {
+		if (keep) {
+			subscribed.fetch_or(1u << type);
+		} else {
+			subscribed.fetch_and(~(1u << type));
+		}
+	}
+
+	/** Whether events of a type are kept */
+	bool isSubscribed(/** An InputEventType */ int type) const {
+		return (subscribed.load(std::memory_order_relaxed) & (1u << type)) != 0;
+	}
+
+	/** Sees an event as SDL queues it, keeping it if it is wanted. Returns whether SDL
+		should queue it too, which it shouldn't for input. */
+	bool filter(const SDL_Event& event) {
+		InputEvent input;
+		memset(&input, 0, sizeof(input));
+		input.timestamp = event.common.timestamp;
+		switch (event.type) {
+			case SDL_KEYDOWN:
+			case SDL_KEYUP:
+				input.type = event.type == SDL_KEYDOWN ? INPUT_KEY_DOWN : INPUT_KEY_UP;
+				input.code = (Uint16) event.key.keysym.scancode;
+				input.x = event.key.repeat;
+				break;
+			case SDL_MOUSEMOTION:
+				input.type = INPUT_MOUSE_MOTION;
+				input.x = (Sint16) event.motion.x;
+				input.y = (Sint16) event.motion.y;
+				input.device = (Sint32) event.motion.which;
+				break;
+			case SDL_MOUSEBUTTONDOWN:
+			case SDL_MOUSEBUTTONUP:
+				input.type = event.type == SDL_MOUSEBUTTONDOWN ? INPUT_MOUSE_DOWN : INPUT_MOUSE_UP;
+				input.code = event.button.button;
+				input.x = (Sint16) event.button.x;
+				input.y = (Sint16) event.button.y;
+				input.device = (Sint32) event.button.which;
+				break;
+			case SDL_MOUSEWHEEL:
+				input.type = INPUT_MOUSE_WHEEL;
+				input.x = (Sint16) event.wheel.x;
+				input.y = (Sint16) event.wheel.y;
+				input.device = (Sint32) event.wheel.which;
+				break;
+			case SDL_CONTROLLERAXISMOTION:
+				input.type = INPUT_CONTROLLER_AXIS;
+				input.code = event.caxis.axis;
+				input.x = event.caxis.value;
+				input.device = event.caxis.which;
+				break;
+			case SDL_CONTROLLERBUTTONDOWN:
+			case SDL_CONTROLLERBUTTONUP:
+				input.type = event.type == SDL_CONTROLLERBUTTONDOWN ? INPUT_CONTROLLER_DOWN : INPUT_CONTROLLER_UP;
+				input.code = event.cbutton.button;
+				input.device = event.cbutton.which;
+				break;
+			case SDL_TEXTINPUT:
+			case SDL_TEXTEDITING:
+			case SDL_FINGERDOWN:
+			case SDL_FINGERUP:
+			case SDL_FINGERMOTION:
+				// Nothing reads these.
+				return false;
+			default:
+				// Quitting, windows, devices and raw joysticks still go through SDL's
+				// queue, as SDL's own event watches rely on them.
+				return true;
+		}
+		if (isSubscribed(input.type)) {
+			push(input);
+		}
+		return false;
+	}
+
+	/** Moves every event kept since the last drain into events, oldest first */
+	void drain(/** Receives the events */ std::vector<InputEvent>& events) {
+		Uint32 tail = read.load(std::memory_order_relaxed);
+		Uint32 head = written.load(std::memory_order_acquire);
+		events.clear();
+		events.reserve(head - tail);
+		for (Uint32 i = tail; i != head; i++) {
+			events.push_back(ring[i % CAPACITY]);
+		}
+		read.store(head, std::memory_order_release);
+	}
+
+	/** The number of events dropped because the buffer was full */
+	int getDropped() const {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	/** Adds an event, unless the buffer is full */
+	void push(const InputEvent& event) {
+		Uint32 head = written.load(std::memory_order_relaxed);
+		if (head - read.load(std::memory_order_acquire) >= CAPACITY) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		ring[head % CAPACITY] = event;
+		written.store(head + 1, std::memory_order_release);
+	}
+
+	/** The events, as a ring buffer */
+	InputEvent ring[CAPACITY];
+	/** The number of events ever written */
+	std::atomic<Uint32> written{0};
+	/** The number of events ever read */
+	std::atomic<Uint32> read{0};
+	/** A bit for each InputEventType kept */
+	std::atomic<Uint32> subscribed{0};
+	/** Events dropped because the buffer was full */
+	std::atomic<int> dropped{0};
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <vector>
+
+#include "FramePacer.h"
+
+/** Measures how long input takes to reach the screen: from when SDL first sees a key
+	or button change to when the frame drawn after it has been presented. Events are
+	timestamped with the performance counter as SDL queues them, rather than when the
+	game gets around to reading them. */
+class InputLatency {
+public:
+	/** How many recent measurements the statistics cover */
+	static const int HISTORY = 240;
+
+	/** Creates a meter that isn't watching yet */
+	InputLatency() : frequency((double) SDL_GetPerformanceFrequency()) {
+		history.reserve(HISTORY);
+	}
+
+	/** Timestamps the event if it is the first key or button change since the game last
+		read input. Call as SDL queues each event, from whichever thread queues it. */
+	void arrived(const SDL_Event& event) {
+		bool input = false;
+		switch (event.type) {
+			case SDL_KEYDOWN:
+				input = event.key.repeat == 0;
+				break;
+			case SDL_KEYUP:
+			case SDL_MOUSEBUTTONDOWN:
+			case SDL_MOUSEBUTTONUP:
+			case SDL_CONTROLLERBUTTONDOWN:
+			case SDL_CONTROLLERBUTTONUP:
+				input = true;
+				break;
+		}
+		if (input) {
+			Uint64 none = 0;
+			pending.compare_exchange_strong(none, SDL_GetPerformanceCounter());
+		}
+	}
+
+	/** Records that the game has just read input, so everything that arrived so far
+		shows in the frame being drawn */
+	void sampled() {
+		Uint64 arrived = pending.exchange(0);
+		if (shown == 0) {
+			shown = arrived;
+		}
+	}
+
+	/** Records that a frame has just been presented, measuring the input it showed */
+	void presented() {
+		if (shown == 0) {
+			lastLatency = 0;
+			return;
+		}
+		lastLatency = (SDL_GetPerformanceCounter() - shown) * 1000.0 / frequency;
+		shown = 0;
+		if ((int) history.size() < HISTORY) {
+			history.push_back(lastLatency);
+		} else {
+			history[next] = lastLatency;
+		}
+		next = (next + 1) % HISTORY;
+	}
+
+	/** The latency in milliseconds of the input shown by the last frame presented,
+		or 0 if there was no new input */
+	double getLatency() const {
+		return lastLatency;
+	}
+
+	/** The given percentile (0 to 100) of recent latencies, in milliseconds */
+	double getLatencyPercentile(double percentile) {
+		scratch = history;
+		return FramePacer::percentileOf(scratch, percentile);
+	}
+
+private:
+	InputLatency(const InputLatency&);
+	InputLatency& operator=(const InputLatency&);
+
+	/** Performance counter ticks per second */
+	double frequency;
+	/** When the oldest input the game hasn't read arrived, or 0 */
+	std::atomic<Uint64> pending{0};
+	/** When the oldest input read for the frame being drawn arrived, or 0 */
+	Uint64 shown = 0;
+	/** The latency of the last frame presented in milliseconds */
+	double lastLatency = 0;
+	/** Recent latencies in milliseconds, as a ring buffer */
+	std::vector<double> history;
+	/** Where the next latency goes in history */
+	int next = 0;
+	/** Scratch space for computing percentiles */
+	std::vector<double> scratch;
+};
+
+#endif
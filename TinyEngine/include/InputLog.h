@@ -0,0 +1,180 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <SDL2/SDL.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "InputState.h"
+
+/** The start of an input log file. The changes follow it. */
+struct InputLogHeader {
+	/** Always "TEIN" */
+	char magic[4];
+	/** The log format version */
+	Uint32 version;
+	/** The number of frames recorded */
+	Uint32 frames;
+	/** The number of changes following the header */
+	Uint32 count;
+};
+
+/** The keyboard as of one frame of an input log. Only frames where something changed
+	are logged; the scancodes of the keys down follow it. */
+struct InputLogChange {
+	/** The frame it happened on, counting from 0 */
+	Uint32 frame;
+	/** Whether the window had been asked to close */
+	Uint16 quit;
+	/** The number of keys down */
+	Uint16 keys;
+};
+
+/** Records the keyboard frame by frame, and plays it back, so a game can be run
+	again and again with exactly the same input. The whole log is kept in memory so
+	recording and replaying never touch the disk mid-game. */
+class InputLog {
+public:
+	/** The log format version */
+	static const Uint32 VERSION = 1;
+
+	/** Forgets the log and starts recording a new one */
+	void startRecording() {
+		changes.clear();
+		keys.clear();
+		frames = 0;
+		last.reset();
+		lastQuit = false;
+	}
+
+	/** Appends a frame */
+	void record(const InputState::Keys& down, bool quit) {
+		if (frames == 0 || down != last || quit != lastQuit) {
+			InputLogChange change;
+			change.frame = frames;
+			change.quit = quit ? 1 : 0;
+			size_t first = keys.size();
+			for (int i = 0; i < SDL_NUM_SCANCODES; i++) {
+				if (down[i]) {
+					keys.push_back((Uint16) i);
+				}
+			}
+			change.keys = (Uint16) (keys.size() - first);
+			changes.push_back(Change(change, first));
+			last = down;
+			lastQuit = quit;
+		}
+		frames++;
+	}
+
+	/** Writes the log to a file */
+	bool save(const std::string& path) const {
+		InputLogHeader header;
+		memcpy(header.magic, "TEIN", 4);
+		header.version = VERSION;
+		header.frames = frames;
+		header.count = (Uint32) changes.size();
+
+		SDL_RWops* out = SDL_RWFromFile(path.c_str(), "wb");
+		if (out == NULL) {
+			return false;
+		}
+		bool ok = SDL_RWwrite(out, &header, sizeof(header), 1) == 1;
+		for (size_t i = 0; i < changes.size() && ok; i++) {
+			ok = SDL_RWwrite(out, &changes[i].change, sizeof(InputLogChange), 1) == 1;
+			if (ok && changes[i].change.keys > 0) {
+				ok = SDL_RWwrite(out, &keys[changes[i].first], sizeof(Uint16), changes[i].change.keys) == changes[i].change.keys;
+			}
+		}
+		return SDL_RWclose(out) == 0 && ok;
+	}
+
+	/** Reads a log from a file and starts replaying it from its first frame. Returns
+		false, leaving the log empty, if it isn't an input log or is damaged. */
+	bool load(const std::string& path) {
+		startRecording();
+		SDL_RWops* rw = SDL_RWFromFile(path.c_str(), "rb");
+		if (rw == NULL) {
+			return false;
+		}
+		InputLogHeader header;
+		bool ok = SDL_RWread(rw, &header, sizeof(header), 1) == 1
+			&& memcmp(header.magic, "TEIN", 4) == 0 && header.version == VERSION;
+		for (Uint32 i = 0; ok && i < header.count; i++) {
+			InputLogChange change;
+			ok = SDL_RWread(rw, &change, sizeof(change), 1) == 1 && change.frame < header.frames
+				&& (changes.empty() || change.frame > changes.back().change.frame);
+			size_t first = keys.size();
+			if (ok && change.keys > 0) {
+				keys.resize(first + change.keys);
+				ok = SDL_RWread(rw, &keys[first], sizeof(Uint16), change.keys) == change.keys;
+			}
+			changes.push_back(Change(change, first));
+		}
+		SDL_RWclose(rw);
+		if (!ok) {
+			SDL_Log("%s is not a valid input log", path.c_str());
+			startRecording();
+			return false;
+		}
+		frames = header.frames;
+		next = 0;
+		played = 0;
+		return true;
+	}
+
+	/** Plays back the next frame. Returns false once every frame has been played. */
+	bool replay(/** Receives the keys down */ InputState::Keys& down, /** Receives whether to quit */ bool& quit) {
+		if (played >= frames) {
+			return false;
+		}
+		while (next < changes.size() && changes[next].change.frame <= played) {
+			const Change& change = changes[next++];
+			last.reset();
+			for (Uint16 i = 0; i < change.change.keys; i++) {
+				Uint16 key = keys[change.first + i];
+				if (key < SDL_NUM_SCANCODES) {
+					last.set(key);
+				}
+			}
+			lastQuit = change.change.quit != 0;
+		}
+		down = last;
+		quit = lastQuit;
+		played++;
+		return true;
+	}
+
+	/** The number of frames recorded or loaded */
+	Uint32 getFrames() const {
+		return frames;
+	}
+
+private:
+	/** A change, and where its keys start in keys */
+	struct Change {
+		Change(const InputLogChange& change, size_t first) : change(change), first(first) {}
+		/** The change as stored */
+		InputLogChange change;
+		/** The index of its first key */
+		size_t first;
+	};
+
+	/** Every change in order */
+	std::vector<Change> changes;
+	/** The keys of every change, back to back */
+	std::vector<Uint16> keys;
+	/** The number of frames recorded or loaded */
+	Uint32 frames = 0;
+	/** The next change to replay */
+	size_t next = 0;
+	/** The number of frames replayed */
+	Uint32 played = 0;
+	/** The keys down as of the last frame recorded or replayed */
+	InputState::Keys last;
+	/** Whether quit was set as of the last frame recorded or replayed */
+	bool lastQuit = false;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef INPUT_STATE_H
+#define INPUT_STATE_H
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <bitset>
+
+/** The keyboard as it was when the frame started, and as it was the frame before, so
+	a key can be asked about any number of times per frame without touching the event
+	queue. Keys are scancodes: physical positions on the keyboard, whatever the layout. */
+class InputState {
+public:
+	/** The keys down, by scancode */
+	typedef std::bitset<SDL_NUM_SCANCODES> Keys;
+
+	/** Takes a new snapshot from SDL's keyboard state. Events must already have been
+		pumped this frame. */
+	void update() {
+		update(readKeyboard());
+	}
+
+	/** Takes a new snapshot of the given keys, such as ones being replayed */
+	void update(/** The keys down */ const Keys& keys) {
+		previous = current;
+		current = keys;
+	}
+
+	/** Brings the latest snapshot up to date from SDL's keyboard state, still comparing
+		it with the snapshot before, so keys pressed since the frame started count as
+		just pressed. Events must already have been pumped. */
+	void latch() {
+		current = readKeyboard();
+	}
+
+	/** The keys down in the latest snapshot */
+	const Keys& getKeys() const {
+		return current;
+	}
+
+	/** Whether the key is held down */
+	bool pressed(SDL_Scancode key) const {
+		return valid(key) && current[key];
+	}
+
+	/** Whether the key went down since the last snapshot */
+	bool justPressed(SDL_Scancode key) const {
+		return valid(key) && current[key] && !previous[key];
+	}
+
+	/** Whether the key came up since the last snapshot */
+	bool justReleased(SDL_Scancode key) const {
+		return valid(key) && !current[key] && previous[key];
+	}
+
+private:
+	/** Returns the keys SDL's keyboard state has down */
+	static Keys readKeyboard() {
+		int count = 0;
+		const Uint8* state = SDL_GetKeyboardState(&count);
+		Keys keys;
+		count = std::min(count, (int) SDL_NUM_SCANCODES);
+		for (int i = 0; i < count; i++) {
+			if (state[i]) {
+				keys.set(i);
+			}
+		}
+		return keys;
+	}
+
+	/** Whether the key is one SDL tracks. Unknown keys are never down. */
+	static bool valid(SDL_Scancode key) {
+		return key > SDL_SCANCODE_UNKNOWN && key < SDL_NUM_SCANCODES;
+	}
+
+	/** Keys down in the latest snapshot */
+	Keys current;
+	/** Keys down in the snapshot before */
+	Keys previous;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef KEY_NAMES_H
+#define KEY_NAMES_H
+
+#include <SDL2/SDL.h>
+
+/** A key the engine has a name for */
+struct KeyName {
+	/** The name games check it by, such as "space" */
+	const char* name;
+	/** The name of its constant in the Python module, such as "K_SPACE" */
+	const char* constant;
+	/** Its physical position */
+	SDL_Scancode scancode;
+};
+
+/** The names of the keys games can check. The table is sorted by name when compiled,
+	so a name is found by binary search without building anything at startup. */
+class KeyNames {
+public:
+	/** The number of named keys */
+	static constexpr int COUNT = 77;
+
+	/** Returns the key at index, for 0 <= index < COUNT */
+	static constexpr const KeyName& at(int index) {
+		return TABLE[index];
+	}
+
+	/** Returns the scancode of the named key, or SDL_SCANCODE_UNKNOWN */
+	static constexpr SDL_Scancode find(const char* name) {
+		int low = 0;
+		int high = COUNT - 1;
+		while (low <= high) {
+			int middle = (low + high) / 2;
+			int order = compare(TABLE[middle].name, name);
+			if (order == 0) {
+				return TABLE[middle].scancode;
+			} else if (order < 0) {
+				low = middle + 1;
+			} else {
+				high = middle - 1;
+			}
+		}
+		return SDL_SCANCODE_UNKNOWN;
+	}
+
+	/** Whether every name comes before the next, which find relies on */
+	static constexpr bool sorted() {
+		for (int i = 1; i < COUNT; i++) {
+			if (compare(TABLE[i - 1].name, TABLE[i].name) >= 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	/** strcmp, usable at compile time */
+	static constexpr int compare(const char* a, const char* b) {
+		while (*a != 0 && *a == *b) {
+			a++;
+			b++;
+		}
+		return (int) (unsigned char) *a - (int) (unsigned char) *b;
+	}
+
+	/** Every named key, sorted by name in byte order */
+	static constexpr KeyName TABLE[COUNT] = {
+		{ "'", "K_QUOTE", SDL_SCANCODE_APOSTROPHE },
+		{ ",", "K_COMMA", SDL_SCANCODE_COMMA },
+		{ "-", "K_MINUS", SDL_SCANCODE_MINUS },
+		{ ".", "K_PERIOD", SDL_SCANCODE_PERIOD },
+		{ "/", "K_SLASH", SDL_SCANCODE_SLASH },
+		{ "0", "K_0", SDL_SCANCODE_0 },
+		{ "1", "K_1", SDL_SCANCODE_1 },
+		{ "2", "K_2", SDL_SCANCODE_2 },
+		{ "3", "K_3", SDL_SCANCODE_3 },
+		{ "4", "K_4", SDL_SCANCODE_4 },
+		{ "5", "K_5", SDL_SCANCODE_5 },
+		{ "6", "K_6", SDL_SCANCODE_6 },
+		{ "7", "K_7", SDL_SCANCODE_7 },
+		{ "8", "K_8", SDL_SCANCODE_8 },
+		{ "9", "K_9", SDL_SCANCODE_9 },
+		{ ";", "K_SEMICOLON", SDL_SCANCODE_SEMICOLON },
+		{ "=", "K_EQUALS", SDL_SCANCODE_EQUALS },
+		{ "[", "K_LEFTBRACKET", SDL_SCANCODE_LEFTBRACKET },
+		{ "\\", "K_BACKSLASH", SDL_SCANCODE_BACKSLASH },
+		{ "]", "K_RIGHTBRACKET", SDL_SCANCODE_RIGHTBRACKET },
+		{ "`", "K_BACKQUOTE", SDL_SCANCODE_GRAVE },
+		{ "a", "K_A", SDL_SCANCODE_A },
+		{ "b", "K_B", SDL_SCANCODE_B },
+		{ "back", "K_BACK", SDL_SCANCODE_BACKSPACE },
+		{ "c", "K_C", SDL_SCANCODE_C },
+		{ "capslock", "K_CAPSLOCK", SDL_SCANCODE_CAPSLOCK },
+		{ "d", "K_D", SDL_SCANCODE_D },
+		{ "delete", "K_DELETE", SDL_SCANCODE_DELETE },
+		{ "down", "K_DOWN", SDL_SCANCODE_DOWN },
+		{ "e", "K_E", SDL_SCANCODE_E },
+		{ "esc", "K_ESC", SDL_SCANCODE_ESCAPE },
+		{ "f", "K_F", SDL_SCANCODE_F },
+		{ "f1", "K_F1", SDL_SCANCODE_F1 },
+		{ "f10", "K_F10", SDL_SCANCODE_F10 },
+		{ "f11", "K_F11", SDL_SCANCODE_F11 },
+		{ "f12", "K_F12", SDL_SCANCODE_F12 },
+		{ "f2", "K_F2", SDL_SCANCODE_F2 },
+		{ "f3", "K_F3", SDL_SCANCODE_F3 },
+		{ "f4", "K_F4", SDL_SCANCODE_F4 },
+		{ "f5", "K_F5", SDL_SCANCODE_F5 },
+		{ "f6", "K_F6", SDL_SCANCODE_F6 },
+		{ "f7", "K_F7", SDL_SCANCODE_F7 },
+		{ "f8", "K_F8", SDL_SCANCODE_F8 },
+		{ "f9", "K_F9", SDL_SCANCODE_F9 },
+		{ "g", "K_G", SDL_SCANCODE_G },
+		{ "h", "K_H", SDL_SCANCODE_H },
+		{ "home", "K_HOME", SDL_SCANCODE_HOME },
+		{ "i", "K_I", SDL_SCANCODE_I },
+		{ "j", "K_J", SDL_SCANCODE_J },
+		{ "k", "K_K", SDL_SCANCODE_K },
+		{ "l", "K_L", SDL_SCANCODE_L },
+		{ "l_alt", "K_L_ALT", SDL_SCANCODE_LALT },
+		{ "l_ctrl", "K_L_CTRL", SDL_SCANCODE_LCTRL },
+		{ "l_shift", "K_L_SHIFT", SDL_SCANCODE_LSHIFT },
+		{ "left", "K_LEFT", SDL_SCANCODE_LEFT },
+		{ "m", "K_M", SDL_SCANCODE_M },
+		{ "n", "K_N", SDL_SCANCODE_N },
+		{ "o", "K_O", SDL_SCANCODE_O },
+		{ "p", "K_P", SDL_SCANCODE_P },
+		{ "q", "K_Q", SDL_SCANCODE_Q },
+		{ "r", "K_R", SDL_SCANCODE_R },
+		{ "r_alt", "K_R_ALT", SDL_SCANCODE_RALT },
+		{ "r_ctrl", "K_R_CTRL", SDL_SCANCODE_RCTRL },
+		{ "r_shift", "K_R_SHIFT", SDL_SCANCODE_RSHIFT },
+		{ "return", "K_RETURN", SDL_SCANCODE_RETURN },
+		{ "right", "K_RIGHT", SDL_SCANCODE_RIGHT },
+		{ "s", "K_S", SDL_SCANCODE_S },
+		{ "space", "K_SPACE", SDL_SCANCODE_SPACE },
+		{ "t", "K_T", SDL_SCANCODE_T },
+		{ "tab", "K_TAB", SDL_SCANCODE_TAB },
+		{ "u", "K_U", SDL_SCANCODE_U },
+		{ "up", "K_UP", SDL_SCANCODE_UP },
+		{ "v", "K_V", SDL_SCANCODE_V },
+		{ "w", "K_W", SDL_SCANCODE_W },
+		{ "x", "K_X", SDL_SCANCODE_X },
+		{ "y", "K_Y", SDL_SCANCODE_Y },
+		{ "z", "K_Z", SDL_SCANCODE_Z },
+	};
+};
+
+static_assert(KeyNames::sorted(), "KeyNames::TABLE must be sorted by name for find");
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <SDL2/SDL.h>
+
+/** Builds mipmaps: copies of an image halved again and again, so it can be drawn much
+	smaller from a copy near that size instead of skipping over most of its pixels.
+	Each level averages 2x2 blocks of the one above, weighted by alpha so the color of
+	transparent pixels (such as the green screen) doesn't bleed into the edges. */
+class MipChain {
+public:
+	/** Returns how many times an image can be halved before a side would go below one pixel */
+	static int levels(int w, int h) {
+		int count = 0;
+		while (w >= 2 && h >= 2) {
+			w /= 2;
+			h /= 2;
+			count++;
+		}
+		return count;
+	}
+
+	/** Returns the level to draw a w by h part of an image from when drawing it at dstW
+		by dstH: the smallest level that still has at least one pixel per pixel drawn */
+	static int levelFor(int w, int h, int dstW, int dstH) {
+		if (dstW <= 0 || dstH <= 0) {
+			return 0;
+		}
+		int level = 0;
+		while ((w >> (level + 1)) >= dstW && (h >> (level + 1)) >= dstH) {
+			level++;
+		}
+		return level;
+	}
+
+	/** Returns a copy of a 32 bit image with alpha at half its width and height, or NULL */
+	static SDL_Surface* halve(/** The image, which must not be RLE encoded */ SDL_Surface* image) {
+		const SDL_PixelFormat* format = image->format;
+		int w = image->w / 2;
+		int h = image->h / 2;
+		SDL_Surface* half = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format->format);
+		if (half == NULL) {
+			return NULL;
+		}
+
+		for (int y = 0; y < h; y++) {
+			const Uint32* above = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(image->pixels) + 2 * y * image->pitch);
+			const Uint32* below = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(image->pixels) + (2 * y + 1) * image->pitch);
+			Uint32* out = reinterpret_cast<Uint32*>(static_cast<Uint8*>(half->pixels) + y * half->pitch);
+			for (int x = 0; x < w; x++) {
+				Uint32 block[4] = { above[2 * x], above[2 * x + 1], below[2 * x], below[2 * x + 1] };
+				Uint32 r = 0, g = 0, b = 0, a = 0;
+				for (int i = 0; i < 4; i++) {
+					Uint32 alpha = (block[i] & format->Amask) >> format->Ashift;
+					r += ((block[i] & format->Rmask) >> format->Rshift) * alpha;
+					g += ((block[i] & format->Gmask) >> format->Gshift) * alpha;
+					b += ((block[i] & format->Bmask) >> format->Bshift) * alpha;
+					a += alpha;
+				}
+				if (a > 0) {
+					r = (r + a / 2) / a;
+					g = (g + a / 2) / a;
+					b = (b + a / 2) / a;
+				}
+				a = (a + 2) / 4;
+				out[x] = (r << format->Rshift) | (g << format->Gshift) | (b << format->Bshift) | (a << format->Ashift);
+			}
+		}
+		return half;
+	}
+};
+
+#endif
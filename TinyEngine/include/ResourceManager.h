@@ -5,83 +5,985 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_image.h>
+#include <cctype>
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
+#include <tuple>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 
-/** A ResourceManager singleton class */
+#include "AssetPack.h"
+#include "CacheBudget.h"
+#include "ContentHash.h"
+#include "FileWatcher.h"
+#include "ImageHeader.h"
+#include "MipChain.h"
+#include "TextureAtlas.h"
+#include "ThreadPool.h"
+
+/** Tracks a batch of resources given to ResourceManager::preload */
+struct PreloadProgress {
+	/** How many resources were asked for */
+	int total = 0;
+	/** How many are ready to use */
+	int loaded = 0;
+	/** How many could not be loaded */
+	int failed = 0;
+
+	/** Whether every resource has been loaded or has failed */
+	bool isDone() const {
+		return loaded + failed >= total;
+	}
+
+	/** The fraction (0 to 1) of resources that are finished */
+	float getProgress() const {
+		return total == 0 ? 1.0f : (float) (loaded + failed) / total;
+	}
+};
+
+/** Identifies the copy of a resource a lookup returned, so whoever keeps it can check
+	with ResourceManager::isCurrent, without a lock, whether that copy is still cached */
+struct ResourceStamp {
+	/** The resource's slot in the budget it is counted in, or NULL if it isn't in one */
+	const CacheBudget<std::string>::Slot* slot = NULL;
+	/** The slot's version at the lookup */
+	Uint32 version = 0;
+	/** The ResourceManager generation at the lookup */
+	Uint32 generation = 0;
+};
+
+/** A ResourceManager singleton class. Its methods may be called from any thread,
+	but textures still belong to the renderer's thread and should only be created
+	and drawn there. Each thread remembers what it has looked up and answers the same
+	lookup again without taking any lock, until that resource is freed or the
+	generation changes. */
 class ResourceManager {
 public:
-	/** Returns the instance of the ResourceManager */
+	/** Returns the instance of the ResourceManager, creating it on first use.
+		Safe to call from any thread. */
     static ResourceManager& instance() {
-        if (inst_ == NULL) {
-			inst_ = new ResourceManager();
+		ResourceManager* inst = inst_.load(std::memory_order_acquire);
+		if (inst == NULL) {
+			std::lock_guard<std::mutex> lock(instMutex_);
+			inst = inst_.load(std::memory_order_relaxed);
+			if (inst == NULL) {
+				inst = new ResourceManager();
+				inst_.store(inst, std::memory_order_release);
+			}
 		}
-        return *inst_;
+        return *inst;
     }
 
-	/** Get the dimensions (width, height) of a given resource's Surface. */
-	SDL_Point getIMGDimensions(/** The string pointing to the surface */ std::string resource) {
-		SDL_Surface* surface = IMG_Load(resource.c_str());
-
-		if (surface == NULL) {
-			SDL_Log("Failed to allocate surface");
+	/** Get the dimensions (width, height) of a given image, or (0, 0) if it can't be read.
+		Sizes come from whatever is cheapest: the sizes recorded whenever an image loads,
+		a cached texture, an asset pack's index or the file's header. Only images that
+		aren't PNG or JPEG are decoded, and only once. */
+	SDL_Point getIMGDimensions(/** The string pointing to the image */ std::string resource) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.sizes.find(resource);
+		if (cached != cache.sizes.end()) {
+			return cached->second;
+		}
+		{
+			ReadLock lock(mutex_);
+			auto found = imageSizes_.find(resource);
+			if (found != imageSizes_.end()) {
+				return cache.sizes[resource] = found->second;
+			}
 		}
+		WriteLock lock(mutex_);
+		return cache.sizes[resource] = getIMGDimensionsLocked(resource);
+	}
 
-		SDL_Point dimensions = { surface->w, surface->h };
-    SDL_FreeSurface(surface);
-		return dimensions;
+	/** Returns the source rectangle of every frame of a sprite sheet, left to right and
+		then top to bottom. The table is built once per sheet and frame size, and the
+		reference stays valid until the generation changes. */
+	const std::vector<SDL_Rect>& getFrameRects(/** The string pointing to the sprite sheet */ const std::string& resource,
+		/** The width of one frame */ int frameWidth, /** The height of one frame */ int frameHeight) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.frames.find(std::tie(resource, frameWidth, frameHeight));
+		if (cached != cache.frames.end()) {
+			return cached->second;
+		}
+		std::vector<SDL_Rect> frames;
+		bool found = false;
+		{
+			ReadLock lock(mutex_);
+			auto table = frameRects_.find(std::tie(resource, frameWidth, frameHeight));
+			if (table != frameRects_.end()) {
+				frames = table->second;
+				found = true;
+			}
+		}
+		if (!found) {
+			WriteLock lock(mutex_);
+			frames = getFrameRectsLocked(resource, frameWidth, frameHeight);
+		}
+		return cache.frames.insert(std::make_pair(std::make_tuple(resource, frameWidth, frameHeight), std::move(frames))).first->second;
 	}
 
-	/** Returns a SDL_Texture that is scaled to the width and height from the given surface. */
+	/** Returns a texture of the image for drawing it at width by height: the smallest
+		mip level at least that size, or the full image if it isn't drawn at half size or
+		less. Draw it scaled to width by height. */
 	SDL_Texture* getScaledTexture(SDL_Renderer* ren, std::string resource, Uint16 width, Uint16 height) {
-		std::string sized_resource = resource + std::to_string(width) + std::to_string(height);
-		if (textures_.count(sized_resource) > 0) {
-			return textures_[sized_resource];
+		WriteLock lock(mutex_);
+		SDL_Texture* texture = getTextureLocked(resource, ren);
+		if (texture == NULL) {
+			return NULL;
+		}
+		int w = 0;
+		int h = 0;
+		SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+		int level = MipChain::levelFor(w, h, width, height);
+		SDL_Texture* mip = getMipLocked(resource, level);
+		return mip != NULL ? mip : texture;
+	}
+
+	/** Returns the image at mip level level, 1/2^level of its full size, for drawing it
+		at that fraction of its size or less. level is lowered if the image is too small
+		to have it. Returns NULL for level 0, for images packed into the atlas, which
+		are small anyway, and for images loaded with mipmaps off. The levels are built
+		when the image's texture is created, and are freed with it. */
+	SDL_Texture* getMip(/** The string pointing to the resource */ const std::string& resource,
+		/** The level wanted; receives the level returned */ int& level) {
+		if (level <= 0) {
+			return NULL;
+		}
+		ThreadCache& cache = threadCache();
+		auto cached = cache.mips.find(resource);
+		const Cached<std::vector<SDL_Texture*>>* entry = NULL;
+		if (cached != cache.mips.end() && isCurrent(cached->second)) {
+			entry = &cached->second;
+		} else {
+			ReadLock lock(mutex_);
+			const std::string& owner = cachedPath(resource);
+			CacheBudget<std::string>::Slot* slot = textureBudget_.findSlot(owner);
+			if (slot == NULL && regions_.count(owner) == 0) {
+				// Never loaded, so there is nothing to remember yet.
+				level = 0;
+				return NULL;
+			}
+			// Levels are only ever built with their texture, so an image without any, such
+			// as one packed into the atlas, is remembered as having none too, until its
+			// texture's version changes.
+			auto found = mips_.find(owner);
+			entry = &remember(cache.mips, resource, found != mips_.end() ? found->second : std::vector<SDL_Texture*>(), slot);
+		}
+		const std::vector<SDL_Texture*>& chain = entry->value;
+		if (chain.empty()) {
+			level = 0;
+			return NULL;
+		}
+		level = std::min(level, (int) chain.size());
+		return chain[level - 1];
+	}
+
+	/** Returns a SDL_Texture.
+		Any source with pure green (0, 255, 0) will have those pixels rendered transparently as if on a green screen. */
+    SDL_Texture* getTexture(/** The string pointing to the resource */std::string resource,
+		/** The SDL_Renderer to render the Texture with */ SDL_Renderer* ren) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.textures.find(resource);
+		if (cached != cache.textures.end() && isCurrent(cached->second)) {
+			hitCached(textureBudget_, cached->second, cache.textureHits);
+			return cached->second.value;
+		}
+		{
+			ReadLock lock(mutex_);
+			const std::string& owner = cachedPath(resource);
+			auto found = textures_.find(owner);
+			if (found != textures_.end()) {
+				textureBudget_.hit(owner);
+				return remember(cache.textures, resource, found->second, textureBudget_.findSlot(owner)).value;
+			}
+		}
+		WriteLock lock(mutex_);
+		SDL_Texture* texture = getTextureLocked(resource, ren);
+		if (texture == NULL) {
+			return NULL;
+		}
+		return remember(cache.textures, resource, texture, textureBudget_.findSlot(cachedPath(resource))).value;
+    }
+
+	/** Decodes the image at the given path and records its size. Pure green (0, 255, 0)
+		pixels are marked transparent with a color key. Images in an open asset pack
+		are used without decoding. The caller frees the surface. */
+	SDL_Surface* loadImage(/** The string pointing to the resource */ std::string resource) {
+		WriteLock lock(mutex_);
+		return loadImageLocked(resource);
+	}
+
+	/** Looks up an image for a renderer that keeps its own textures, such as the OpenGL
+		one. path receives the path its texture should be kept under, which copies of the
+		image share. Returns whether that texture is counted in the texture budget, in
+		which case the use is recorded and stamp, if given, receives a stamp that stays
+		current until the texture should be freed. Otherwise the renderer should free any
+		texture it still keeps under path, which was evicted, then load the image and call
+		trackExternalTexture. */
+	bool findExternalTexture(/** The image path */ const std::string& resource,
+		/** Receives the path the texture is kept under */ std::string& path,
+		/** Receives the stamp of the texture, if it is counted and this is not NULL */ ResourceStamp* stamp = NULL) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.externalTextures.find(resource);
+		if (cached != cache.externalTextures.end() && isCurrent(cached->second)) {
+			hitCached(textureBudget_, cached->second, cache.textureHits);
+			path = answer(cache, cached->second, stamp);
+			return true;
+		}
+		{
+			ReadLock lock(mutex_);
+			auto alias = aliases_.find(resource);
+			if (alias != aliases_.end() && externalTextures_.count(alias->second) > 0) {
+				textureBudget_.hit(alias->second);
+				path = answer(cache, remember(cache.externalTextures, resource, alias->second,
+					textureBudget_.findSlot(alias->second)), stamp);
+				return true;
+			}
+		}
+		WriteLock lock(mutex_);
+		path = canonicalPath(resource);
+		if (externalTextures_.count(path) == 0) {
+			// Not loaded yet, so there is nothing to remember.
+			return false;
+		}
+		textureBudget_.hit(path);
+		answer(cache, remember(cache.externalTextures, resource, path, textureBudget_.findSlot(path)), stamp);
+		return true;
+	}
+
+	/** Counts a texture a renderer keeps itself against the texture budget, under a path
+		from findExternalTexture, so it is evicted least recently used first and pinned
+		like the SDL renderer's own. Only one renderer should keep textures at a time. */
+	void trackExternalTexture(/** The path from findExternalTexture */ const std::string& resource,
+		/** The width of the texture */ int w, /** The height of the texture */ int h,
+		/** The bytes per pixel of the texture */ int bytesPerPixel,
+		/** Receives the paths of textures the renderer should now free */ std::vector<std::string>& evicted,
+		/** Receives the stamp of the texture, if not NULL */ ResourceStamp* stamp = NULL) {
+		WriteLock lock(mutex_);
+		externalTextures_[resource] = bytesPerPixel;
+		textureBudget_.add(resource, (size_t) bytesPerPixel * w * h);
+		evictTextures(resource);
+		for (size_t i = 0; i < externalEvictions_.size(); i++) {
+			// An earlier eviction of this texture, which the renderer found out about when it looked it up.
+			if (externalEvictions_[i] != resource) {
+				evicted.push_back(externalEvictions_[i]);
+			}
+		}
+		externalEvictions_.clear();
+		if (stamp != NULL) {
+			CacheBudget<std::string>::Slot* slot = textureBudget_.findSlot(resource);
+			stamp->slot = slot;
+			stamp->version = slot->version.load(std::memory_order_relaxed);
+			stamp->generation = generation_.load(std::memory_order_relaxed);
+		}
+	}
+
+	/** Starts loading the given images, sound effects and fonts on worker threads.
+		Sounds and fonts are ready as soon as they are decoded; decoded images still
+		have to be turned into textures by uploadPreloaded. Audio files over
+		MAX_DECODED_AUDIO bytes are taken to be music, which streams as it plays, so only
+		their bytes are read ahead. */
+	std::shared_ptr<PreloadProgress> preload(/** The resource paths */ const std::vector<std::string>& resources) {
+		std::shared_ptr<PreloadProgress> progress = std::make_shared<PreloadProgress>();
+		progress->total = (int) resources.size();
+		WriteLock lock(mutex_);
+		if (pool_ == NULL) {
+			// Image format libraries have to be loaded before several threads use them at once.
+			IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+			pool_.reset(new ThreadPool(ThreadPool::defaultSize()));
+		}
+
+		for (size_t i = 0; i < resources.size(); i++) {
+			Preloaded job;
+			job.resource = resources[i];
+			job.type = typeOf(resources[i]);
+			job.progress = progress;
+			if (isLoaded(job)) {
+				progress->loaded++;
+				continue;
+			}
+			if (job.type == PRELOAD_IMAGE && (job.surface = packedImage(job.resource)) != NULL) {
+				// Packed images need no decoding, only uploading.
+				job.ok = true;
+				store(job);
+				continue;
+			}
+			if (job.type != PRELOAD_IMAGE && findPacked(job.resource, PACK_FILE) != NULL) {
+				// Sounds and fonts load from a pack as fast as they can be looked up.
+				progress->loaded++;
+				continue;
+			}
+			pool_->submit([this, job]() mutable {
+				decode(job);
+				std::lock_guard<std::mutex> decodedLock(preloadMutex_);
+				decoded_.push_back(std::move(job));
+			});
 		}
+		return progress;
+	}
+
+	/** Adds finished preloads to the caches. Decoded images are passed to upload, which
+		should create their textures, until budgetMs milliseconds have been spent.
+		Call once per frame from the thread that renders. */
+	void uploadPreloaded(/** Creates the texture for a decoded image */ std::function<void(const std::string&)> upload,
+		/** Milliseconds to spend uploading this frame */ double budgetMs) {
+		WriteLock lock(mutex_);
+		if (pool_ == NULL) {
+			return;
+		}
+		std::deque<Preloaded> finished;
+		{
+			std::lock_guard<std::mutex> decodedLock(preloadMutex_);
+			finished.swap(decoded_);
+		}
+		for (auto it = finished.begin(); it != finished.end(); ++it) {
+			store(*it);
+		}
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		double budget = budgetMs * SDL_GetPerformanceFrequency() / 1000.0;
+		while (!pendingUploads_.empty()) {
+			Preloaded job = pendingUploads_.front();
+			pendingUploads_.pop_front();
+			// upload comes back in through getTexture and the like, which take the lock themselves.
+			lock.unlock();
+			upload(job.resource);
+			lock.lock();
+			// Someone may have loaded the image themselves while it was decoding.
+			auto unused = preloadedImages_.find(job.resource);
+			if (unused != preloadedImages_.end()) {
+				SDL_FreeSurface(unused->second);
+				preloadedImages_.erase(unused);
+			}
+			job.progress->loaded++;
+			if (SDL_GetPerformanceCounter() - start >= budget) {
+				break;
+			}
+		}
+	}
+
+	/** Returns the texture holding the given image and where in it the image lies.
+		In atlas mode small images are packed into shared pages, so draws of
+		different images can use the same texture. Other images get their own texture. */
+	TextureRegion getTextureRegion(/** The string pointing to the resource */ std::string resource,
+		/** The SDL_Renderer to render the Texture with */ SDL_Renderer* ren,
+		/** Receives the stamp of the texture returned, if not NULL */ ResourceStamp* stamp = NULL) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.regions.find(resource);
+		if (cached != cache.regions.end() && isCurrent(cached->second)) {
+			hitCached(textureBudget_, cached->second, cache.textureHits);
+			return answer(cache, cached->second, stamp);
+		}
+		{
+			ReadLock lock(mutex_);
+			const std::string& owner = cachedPath(resource);
+			auto found = regions_.find(owner);
+			if (found != regions_.end()) {
+				textureBudget_.hit(owner);
+				return answer(cache, remember(cache.regions, resource, found->second, textureBudget_.findSlot(owner)), stamp);
+			}
+		}
+		WriteLock lock(mutex_);
+		TextureRegion region = getTextureRegionLocked(resource, ren);
+		if (region.texture == NULL) {
+			return region;
+		}
+		return answer(cache, remember(cache.regions, resource, region, textureBudget_.findSlot(cachedPath(resource))), stamp);
+	}
+
+	/** Turns atlas packing of small images on or off. Only affects images loaded afterwards. */
+	void setAtlasEnabled(/** Whether to pack small images */ bool enabled) {
+		WriteLock lock(mutex_);
+		atlasEnabled_ = enabled;
+	}
+
+	/** Sets the width and height of atlas pages created from now on */
+	void setAtlasPageSize(/** The page size in pixels */ int size) {
+		WriteLock lock(mutex_);
+		atlas_.setPageSize(size);
+	}
+
+	/** Turns building mip levels for images on or off. Only affects images loaded afterwards. */
+	void setMipmapsEnabled(/** Whether images get mip levels */ bool enabled) {
+		WriteLock lock(mutex_);
+		mipmapsEnabled_ = enabled;
+	}
+
+	/** Sets the pixel format of an image's texture, such as SDL_PIXELFORMAT_RGB565 for
+		opaque images or SDL_PIXELFORMAT_ARGB4444 for ones that can do with 16 levels per
+		channel, to halve the memory they use. 0 goes back to the renderer's native
+		format. A loaded image is freed, so the format applies from its next draw. */
+	void setTextureFormat(/** The string pointing to the resource */ std::string resource,
+		/** An SDL pixel format, or 0 */ Uint32 format) {
+		WriteLock lock(mutex_);
+		if (format == 0) {
+			textureFormats_.erase(resource);
+		} else {
+			textureFormats_[resource] = format;
+		}
+		auto texture = textures_.find(resource);
+		bool ownTexture = texture != textures_.end();
+		if (ownTexture) {
+			SDL_DestroyTexture(texture->second);
+			textures_.erase(texture);
+			destroyMips(resource);
+			textureBudget_.remove(resource);
+		}
+		if (regions_.erase(resource) > 0 && !ownTexture) {
+			// Packed into an atlas page, which isn't in the budget.
+			generation_++;
+		}
+	}
+
+	/** Returns (images, used pixels, total pixels, fill ratio) for every atlas page */
+	std::vector<std::tuple<int, int, int, float>> getAtlasStats() {
+		ReadLock lock(mutex_);
+		return atlas_.getStats();
+	}
 
-		SDL_Surface* sprite = IMG_Load(resource.c_str());
+	/** Maps an asset pack built by AssetCooker. From then on, resources in the pack are
+		loaded from it instead of from their files. Packs opened later take precedence. */
+	bool openAssetPack(/** The pack file */ std::string path) {
+		std::unique_ptr<AssetPack> pack(new AssetPack());
+		if (!pack->open(path)) {
+			return false;
+		}
+		WriteLock lock(mutex_);
+		packs_.push_back(std::move(pack));
+		return true;
+	}
 
-		if (sprite == NULL) {
+	/** Returns the true-type font at the given path and size.
+		Every size of a font is opened from the same in-memory copy of the file. */
+	TTF_Font* getFont(/** The resource path */ std::string resource,
+		/** The size of the font */ int size) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.fonts.find(std::tie(resource, size));
+		if (cached != cache.fonts.end() && isCurrent(cached->second)) {
+			hitCached(fontBudget_, cached->second, cache.fontHits);
+			return cached->second.value;
+		}
+		{
+			ReadLock lock(mutex_);
+			const std::string& owner = cachedPath(resource);
+			auto found = fonts_.find(std::make_pair(owner, size));
+			if (found != fonts_.end()) {
+				fontBudget_.hit(owner);
+				return remember(cache.fonts, std::make_tuple(resource, size), found->second, fontBudget_.findSlot(owner)).value;
+			}
+		}
+		WriteLock lock(mutex_);
+		TTF_Font* font = getFontLocked(resource, size);
+		if (font == NULL) {
+			return NULL;
+		}
+		return remember(cache.fonts, std::make_tuple(resource, size), font, fontBudget_.findSlot(cachedPath(resource))).value;
+	}
+
+	/** Returns (path, open sizes, file bytes) for every font file in memory */
+	std::vector<std::tuple<std::string, std::vector<int>, size_t>> getFontMemoryUsage() {
+		std::vector<std::tuple<std::string, std::vector<int>, size_t>> usage;
+		ReadLock lock(mutex_);
+		for (auto it = fontFiles_.begin(); it != fontFiles_.end(); ++it) {
+			std::vector<int> sizes;
+			for (auto font = fonts_.lower_bound(std::make_pair(it->first, 0));
+				font != fonts_.end() && font->first.first == it->first; ++font) {
+				sizes.push_back(font->first.second);
+			}
+			usage.push_back(std::make_tuple(it->first, sizes, it->second.size()));
+		}
+		return usage;
+	}
+
+	/** Returns a Mix_Music loaded using the given path */
+	Mix_Music* getMusic(/** The path for the music */ std::string resource) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.music.find(resource);
+		if (cached != cache.music.end() && isCurrent(cached->second)) {
+			hitCached(musicBudget_, cached->second, cache.musicHits);
+			return cached->second.value;
+		}
+		{
+			ReadLock lock(mutex_);
+			auto found = music_.find(resource);
+			if (found != music_.end()) {
+				musicBudget_.hit(resource);
+				return remember(cache.music, resource, found->second, musicBudget_.findSlot(resource)).value;
+			}
+		}
+		WriteLock lock(mutex_);
+		Mix_Music* music = getMusicLocked(resource);
+		if (music == NULL) {
+			return NULL;
+		}
+		return remember(cache.music, resource, music, musicBudget_.findSlot(resource)).value;
+	}
+
+	/** Returns a playable sound chunk from the given resource path */
+	Mix_Chunk* getSFX(/** The resource path */std::string resource,
+		/** Receives the stamp of the sound returned, if not NULL */ ResourceStamp* stamp = NULL) {
+		ThreadCache& cache = threadCache();
+		auto cached = cache.sounds.find(resource);
+		if (cached != cache.sounds.end() && isCurrent(cached->second)) {
+			hitCached(soundBudget_, cached->second, cache.soundHits);
+			return answer(cache, cached->second, stamp);
+		}
+		{
+			ReadLock lock(mutex_);
+			const std::string& owner = cachedPath(resource);
+			auto found = sounds_.find(owner);
+			if (found != sounds_.end()) {
+				soundBudget_.hit(owner);
+				return answer(cache, remember(cache.sounds, resource, found->second, soundBudget_.findSlot(owner)), stamp);
+			}
+		}
+		WriteLock lock(mutex_);
+		Mix_Chunk* sfx = getSFXLocked(resource);
+		if (sfx == NULL) {
+			return NULL;
+		}
+		return answer(cache, remember(cache.sounds, resource, sfx, soundBudget_.findSlot(cachedPath(resource))), stamp);
+	}
+
+	/** Reads a whole file into bytes. Safe to call from any thread. */
+	static bool readFile(std::string resource, std::vector<char>& bytes) {
+		SDL_RWops* rw = SDL_RWFromFile(resource.c_str(), "rb");
+		if (rw == NULL) {
+			return false;
+		}
+		bytes.resize((size_t) SDL_RWsize(rw));
+		size_t read = bytes.empty() ? 0 : SDL_RWread(rw, bytes.data(), bytes.size(), 1);
+		SDL_RWclose(rw);
+		return read == 1;
+	}
+
+	/** Decodes an image and keys out pure green. Safe to call from any thread. */
+	static SDL_Surface* decodeImage(std::string resource) {
+		return keyGreen(IMG_Load(resource.c_str()));
+	}
+
+	/** Decodes an image already read into memory and keys out pure green. Safe to call from any thread. */
+	static SDL_Surface* decodeImage(const std::vector<char>& bytes) {
+		return keyGreen(IMG_Load_RW(SDL_RWFromConstMem(bytes.data(), (int) bytes.size()), 1));
+	}
+
+	/** Marks pure green pixels of a newly decoded image transparent */
+	static SDL_Surface* keyGreen(SDL_Surface* image) {
+		if (image == NULL) {
 			SDL_Log("Failed to allocate surface");
+			return NULL;
 		}
-		else {
-			SDL_Log("Allocated surface successfully");
+		SDL_SetColorKey(image, SDL_TRUE, SDL_MapRGB(image->format, 0, 255, 0));
+		return image;
+	}
 
-			SDL_Surface* scaled = SDL_CreateRGBSurface(sprite->flags, width, height, sprite->format->BitsPerPixel,
-				sprite->format->Rmask, sprite->format->Gmask, sprite->format->Bmask, sprite->format->Amask);
+	/** The kinds of resource that can be preloaded or packed */
+	enum PreloadType { PRELOAD_IMAGE, PRELOAD_SOUND, PRELOAD_FONT };
 
-			SDL_Rect src = { 0, 0, sprite->w, sprite->h };
-			SDL_Rect dst = { 0, 0, width, height };
-			SDL_BlitScaled(sprite, &src, scaled, &dst);
+	/** Audio files up to this size are decoded ahead of time, as sound effects. Longer
+		ones are likely music, which streams from the original bytes. */
+	static const Sint64 MAX_DECODED_AUDIO = 1024 * 1024;
 
-			SDL_Texture* scaledTexture = SDL_CreateTextureFromSurface(ren, scaled);
-			textures_.insert(std::pair<std::string, SDL_Texture*>(sized_resource, scaledTexture));
-			SDL_FreeSurface(sprite);
-			SDL_FreeSurface(scaled);
-			return scaledTexture;
+	/** Guesses what kind of resource a path is from its extension */
+	static PreloadType typeOf(const std::string& resource) {
+		std::string extension = resource.substr(resource.find_last_of('.') + 1);
+		for (size_t i = 0; i < extension.size(); i++) {
+			extension[i] = (char) tolower((unsigned char) extension[i]);
 		}
-		return NULL;
+		if (extension == "ttf" || extension == "otf" || extension == "fon") {
+			return PRELOAD_FONT;
+		}
+		if (extension == "wav" || extension == "ogg" || extension == "mp3" || extension == "flac"
+			|| extension == "opus" || extension == "voc" || extension == "aiff") {
+			return PRELOAD_SOUND;
+		}
+		return PRELOAD_IMAGE;
 	}
 
-	/** Returns a SDL_Texture.
-		Any source with pure green (0, 255, 0) will have those pixels rendered transparently as if on a green screen. */
-    SDL_Texture* getTexture(/** The string pointing to the resource */std::string resource,
-		/** The SDL_Renderer to render the Texture with */ SDL_Renderer* ren) {
-        if (textures_.count(resource) > 0) {
-            return textures_[resource];
+	/** Sets the most bytes a kind of resource may use. When a new resource takes it over
+		budget, the least recently used ones are freed. kind is "textures", "music", "sounds" or "fonts"; 0 means no limit.
+		Images packed into atlas pages are not counted. Returns false for an unknown kind. */
+	bool setCacheBudget(/** The kind of resource */ std::string kind, /** The budget in bytes */ size_t bytes) {
+		WriteLock lock(mutex_);
+		if (kind == "textures") {
+			textureBudget_.setBudget(bytes);
+		} else if (kind == "music") {
+			musicBudget_.setBudget(bytes);
+		} else if (kind == "sounds") {
+			soundBudget_.setBudget(bytes);
+		} else if (kind == "fonts") {
+			fontBudget_.setBudget(bytes);
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	/** Returns (kind, bytes used, budget, entries, hits, misses, evictions) for each kind
+		of resource. Other threads add the hits they answer themselves in batches, so
+		their most recent few may not be counted yet. */
+	std::vector<std::tuple<std::string, size_t, size_t, int, int, int, int>> getCacheStats() {
+		std::vector<std::tuple<std::string, size_t, size_t, int, int, int, int>> stats;
+		ThreadCache& cache = threadCache();
+		flushHits(cache);
+		ReadLock lock(mutex_);
+		stats.push_back(statsOf("textures", textureBudget_));
+		stats.push_back(statsOf("music", musicBudget_));
+		stats.push_back(statsOf("sounds", soundBudget_));
+		stats.push_back(statsOf("fonts", fontBudget_));
+		return stats;
+	}
+
+	/** Keeps a resource from being evicted, whatever its kind, until it is unpinned */
+	void pin(/** The resource path */ std::string resource) {
+		WriteLock lock(mutex_);
+		auto alias = aliases_.find(resource);
+		if (alias != aliases_.end()) {
+			resource = alias->second;
+		}
+		textureBudget_.pin(resource);
+		musicBudget_.pin(resource);
+		soundBudget_.pin(resource);
+		fontBudget_.pin(resource);
+	}
+
+	/** Undoes one pin of a resource */
+	void unpin(/** The resource path */ std::string resource) {
+		WriteLock lock(mutex_);
+		auto alias = aliases_.find(resource);
+		if (alias != aliases_.end()) {
+			resource = alias->second;
+		}
+		textureBudget_.unpin(resource);
+		musicBudget_.unpin(resource);
+		soundBudget_.unpin(resource);
+		fontBudget_.unpin(resource);
+	}
+
+	/** Starts watching a directory for changed files, which reloadChanged then reloads.
+		Returns false if it can't be watched. */
+	bool watch(/** The directory resource paths start with */ std::string directory) {
+		WriteLock lock(mutex_);
+		if (watcher_ == NULL) {
+			watcher_.reset(new FileWatcher());
+		}
+		return watcher_->watch(directory);
+	}
+
+	/** Reloads every loaded resource whose file changed since the last call, as reload
+		does. Returns the paths of the changed files. */
+	std::vector<std::string> reloadChanged(
+		/** Called with every reloaded image, for caches kept outside the ResourceManager */ std::function<void(const std::string&, SDL_Surface*)> imageReloaded,
+		/** Called with every font replaced by a reloaded one, before the old one is closed */ std::function<void(TTF_Font*, TTF_Font*)> fontReplaced) {
+		std::vector<std::string> changed;
+		{
+			ReadLock lock(mutex_);
+			if (watcher_ != NULL) {
+				changed = watcher_->takeChanged();
+			}
+		}
+		for (size_t i = 0; i < changed.size(); i++) {
+			reload(changed[i], imageReloaded, fontReplaced);
+		}
+		return changed;
+	}
+
+	/** Loads a resource again from its file and swaps it into the caches in place, so
+		textures, sounds and fonts already handed out show the new contents. Textures
+		that change size, and sounds, are replaced instead, and the generation changes
+		so handles look them up again. Nothing happens if the resource isn't loaded.
+		Music and scaled textures are not reloaded. Call between frames. */
+	void reload(/** The resource path */ const std::string& resource,
+		/** Called with the new image, if resource is one */ std::function<void(const std::string&, SDL_Surface*)> imageReloaded,
+		/** Called with every font replaced, before the old one is closed */ std::function<void(TTF_Font*, TTF_Font*)> fontReplaced) {
+		WriteLock lock(mutex_);
+		if (!forgetContent(resource)) {
+			return;
+		}
+		std::vector<char> bytes;
+		if (!readFile(resource, bytes)) {
+			SDL_Log("Could not reload %s", resource.c_str());
+			return;
+		}
+
+		std::pair<Uint64, size_t> content(ContentHash::hash(bytes.data(), bytes.size()), bytes.size());
+		bool reloaded;
+		switch (typeOf(resource)) {
+			case PRELOAD_FONT:
+				reloaded = reloadFont(resource, bytes, fontReplaced);
+				break;
+			case PRELOAD_SOUND:
+				reloaded = reloadSFX(resource, bytes);
+				break;
+			default:
+				reloaded = reloadImage(resource, bytes, imageReloaded);
+				break;
+		}
+		if (reloaded) {
+			SDL_Log("Reloaded %s", resource.c_str());
+			contentPaths_.insert(std::make_pair(content, resource));
+		}
+	}
+
+	/** Returns (paths sharing another path's resource, bytes of files not loaded again) */
+	std::pair<int, size_t> getDedupStats() const {
+		ReadLock lock(mutex_);
+		return std::make_pair(dedupedPaths_, dedupedBytes_);
+	}
+
+	/** Returns a number that changes whenever resources that were handed out are
+		replaced wholesale, such as by a reload. Resources freed one at a time to stay
+		under budget only change their own stamps. */
+	Uint32 getGeneration() const {
+		return generation_;
+	}
+
+	/** Whether what a lookup returned with stamp is still cached, so it may still be
+		used. Takes no lock. */
+	bool isCurrent(const ResourceStamp& stamp) const {
+		return stamp.generation == generation_.load(std::memory_order_acquire)
+			&& (stamp.slot == NULL || stamp.slot->version.load(std::memory_order_acquire) == stamp.version);
+	}
+
+	/** Frees the instance. Nothing may be using it, on any thread. */
+    static void reset() {
+		std::lock_guard<std::mutex> lock(instMutex_);
+        delete inst_.load();
+        inst_ = NULL;
+    }
+
+private:
+	/** Private constructor */
+    ResourceManager() : id_(++instances_) {}
+
+	/** Orders tuple keys, and compares them with std::tie views of the same values, so
+		looking up a key holding a path doesn't copy the path */
+	struct TupleLess {
+		typedef void is_transparent;
+		template <typename A, typename B>
+		bool operator()(const A& a, const B& b) const {
+			return a < b;
+		}
+	};
+
+	/** A value a thread looked up, the budget slot its uses are recorded in, or NULL,
+		and that slot's version when it was looked up */
+	template <typename T>
+	struct Cached {
+		T value;
+		CacheBudget<std::string>::Slot* slot;
+		Uint32 version;
+	};
+
+	/** What one thread has looked up. Only that thread touches it, so it needs no lock.
+		It holds copies, never pointers into the shared caches. An entry is only used
+		while its slot's version is unchanged, and the whole cache is emptied whenever
+		the generation changes, since anything in it may have been replaced by then. */
+	struct ThreadCache {
+		/** The generation the lookups were made in */
+		Uint32 generation = 0;
+		std::map<std::string, Cached<SDL_Texture*>> textures;
+		std::map<std::string, Cached<TextureRegion>> regions;
+		std::map<std::tuple<std::string, int>, Cached<TTF_Font*>, TupleLess> fonts;
+		std::map<std::string, Cached<Mix_Music*>> music;
+		std::map<std::string, Cached<Mix_Chunk*>> sounds;
+		std::map<std::string, SDL_Point> sizes;
+		std::map<std::tuple<std::string, int, int>, std::vector<SDL_Rect>, TupleLess> frames;
+		/** Every mip level of an image, or none if it has none */
+		std::map<std::string, Cached<std::vector<SDL_Texture*>>> mips;
+		/** The path each image's texture is kept under by a renderer keeping its own */
+		std::map<std::string, Cached<std::string>> externalTextures;
+		/** Hits not yet added to each budget's count */
+		int textureHits = 0;
+		int fontHits = 0;
+		int musicHits = 0;
+		int soundHits = 0;
+
+		/** Forgets every lookup, keeping the hits still to be counted */
+		void clear() {
+			textures.clear();
+			regions.clear();
+			fonts.clear();
+			music.clear();
+			sounds.clear();
+			sizes.clear();
+			frames.clear();
+			mips.clear();
+			externalTextures.clear();
+		}
+	};
+
+	/** How many hits a thread answers itself before adding them to a budget's count */
+	static const int HIT_BATCH = 64;
+
+	/** Returns the calling thread's cache, emptied first if the generation changed since
+		the thread last used it */
+	ThreadCache& threadCache() {
+		// Plain values, so nothing runs when a thread exits; the instance frees the caches.
+		static thread_local Uint32 instance = 0;
+		static thread_local ThreadCache* cache = NULL;
+		if (instance != id_) {
+			std::unique_ptr<ThreadCache> created(new ThreadCache());
+			cache = created.get();
+			instance = id_;
+			std::lock_guard<std::mutex> lock(threadCachesMutex_);
+			threadCaches_.push_back(std::move(created));
+		}
+		Uint32 generation = generation_.load(std::memory_order_acquire);
+		if (cache->generation != generation) {
+			cache->clear();
+			cache->generation = generation;
+		}
+		return *cache;
+	}
+
+	/** Adds a lookup to a thread's cache and returns the entry. Call while holding the
+		lock, so the slot's version matches the value. */
+	template <typename Map, typename Key, typename T>
+	static const Cached<T>& remember(Map& map, const Key& key, T value, CacheBudget<std::string>::Slot* slot) {
+		Cached<T>& cached = map[key];
+		cached.value = std::move(value);
+		cached.slot = slot;
+		cached.version = slot != NULL ? slot->version.load(std::memory_order_relaxed) : 0;
+		return cached;
+	}
+
+	/** Whether a thread's cached lookup is still what is cached under its slot */
+	template <typename T>
+	static bool isCurrent(const Cached<T>& cached) {
+		return cached.slot == NULL || cached.slot->version.load(std::memory_order_acquire) == cached.version;
+	}
+
+	/** Returns a cached lookup's value, filling in stamp from it if given */
+	template <typename T>
+	static T answer(const ThreadCache& cache, const Cached<T>& cached, ResourceStamp* stamp) {
+		if (stamp != NULL) {
+			stamp->slot = cached.slot;
+			stamp->version = cached.version;
+			stamp->generation = cache.generation;
+		}
+		return cached.value;
+	}
+
+	/** Records a lookup a thread answered from its own cache, without any lock */
+	template <typename T>
+	static void hitCached(CacheBudget<std::string>& budget, const Cached<T>& cached, int& pending) {
+		if (cached.slot != NULL) {
+			budget.touch(cached.slot);
+		}
+		if (++pending >= HIT_BATCH) {
+			budget.addHits(pending);
+			pending = 0;
+		}
+	}
+
+	/** Adds the hits a thread has answered itself to the budgets' counts */
+	void flushHits(ThreadCache& cache) {
+		textureBudget_.addHits(cache.textureHits);
+		fontBudget_.addHits(cache.fontHits);
+		musicBudget_.addHits(cache.musicHits);
+		soundBudget_.addHits(cache.soundHits);
+		cache.textureHits = cache.fontHits = cache.musicHits = cache.soundHits = 0;
+	}
+
+	/** Shared while looking things up, exclusive while loading or changing anything */
+	typedef std::shared_lock<std::shared_timed_mutex> ReadLock;
+	typedef std::unique_lock<std::shared_timed_mutex> WriteLock;
+
+	/** getIMGDimensions, for callers holding the lock */
+	SDL_Point getIMGDimensionsLocked(const std::string& resource) {
+		auto found = imageSizes_.find(resource);
+		if (found != imageSizes_.end()) {
+			return found->second;
+		}
+
+		SDL_Point size = { 0, 0 };
+		auto region = regions_.find(resource);
+		auto texture = textures_.find(resource);
+		const AssetPackEntry* packed = findPacked(resource, PACK_IMAGE);
+		if (region != regions_.end()) {
+			size.x = region->second.rect.w;
+			size.y = region->second.rect.h;
+		} else if (texture != textures_.end()) {
+			SDL_QueryTexture(texture->second, NULL, NULL, &size.x, &size.y);
+		} else if (packed != NULL) {
+			size.x = (int) packed->width;
+			size.y = (int) packed->height;
+		} else if (!ImageHeader::readSize(resource, size)) {
+			SDL_Surface* surface = loadImageLocked(resource);
+			if (surface == NULL) {
+				// Remember the failure too, rather than retrying the file every call.
+				size.x = size.y = 0;
+			} else {
+				SDL_FreeSurface(surface);
+				return imageSizes_[resource];
+			}
+		}
+		imageSizes_[resource] = size;
+		return size;
+	}
+
+	/** getFrameRects, for callers holding the lock */
+	const std::vector<SDL_Rect>& getFrameRectsLocked(const std::string& resource, int frameWidth, int frameHeight) {
+		auto found = frameRects_.find(std::tie(resource, frameWidth, frameHeight));
+		if (found != frameRects_.end()) {
+			return found->second;
+		}
+
+		SDL_Point size = getIMGDimensionsLocked(resource);
+		std::vector<SDL_Rect> frames;
+		if (frameWidth > 0 && frameHeight > 0) {
+			for (int y = 0; y < size.y; y += frameHeight) {
+				for (int x = 0; x + frameWidth <= size.x; x += frameWidth) {
+					SDL_Rect frame = { x, y, frameWidth, frameHeight };
+					frames.push_back(frame);
+				}
+			}
+		}
+		return frameRects_.insert(std::make_pair(std::make_tuple(resource, frameWidth, frameHeight), std::move(frames))).first->second;
+	}
+
+	/** getMip, for callers holding the lock, shared or not */
+	SDL_Texture* getMipLocked(const std::string& resource, int& level) const {
+		if (level <= 0) {
+			return NULL;
+		}
+		auto found = mips_.find(cachedPath(resource));
+		if (found == mips_.end() || found->second.empty()) {
+			level = 0;
+			return NULL;
+		}
+		const std::vector<SDL_Texture*>& chain = found->second;
+		if (level > (int) chain.size()) {
+			level = (int) chain.size();
+		}
+		return chain[level - 1];
+	}
+
+	/** getTexture, for callers holding the lock */
+    SDL_Texture* getTextureLocked(const std::string& resource, SDL_Renderer* ren) {
+        auto found = textures_.find(resource);
+        if (found != textures_.end()) {
+            textureBudget_.hit(resource);
+            return found->second;
         }
 
-        SDL_Surface* spriteSheet = IMG_Load(resource.c_str());
-
-        if (spriteSheet==NULL){
-            SDL_Log("Failed to allocate surface");
-        } else {
-            SDL_Log("Allocating memory for texture");
-		        // Create a texture from our surface
-            // Textures run faster and take advantage of hardware acceleration
-			      SDL_SetColorKey(spriteSheet, SDL_TRUE, SDL_MapRGB(spriteSheet->format, 0, 255, 0));
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(ren, spriteSheet);
-            textures_.insert(std::pair<std::string, SDL_Texture*>(resource, texture));
+        std::vector<char> bytes;
+        const std::string& canonical = canonicalPath(resource, &bytes);
+        if (canonical != resource) {
+            return getTextureLocked(canonical, ren);
+        }
+
+        SDL_Surface* spriteSheet = loadImageLocked(resource, &bytes);
+
+        if (spriteSheet != NULL) {
+            SDL_Texture* texture = createTexture(resource, spriteSheet, ren);
             SDL_FreeSurface(spriteSheet);
             return texture;
         }
@@ -89,54 +991,192 @@ public:
         return NULL;
     }
 
-	/** Returns the true-type font at the given path */
-	TTF_Font* getFont(/** The resource path */ std::string resource,
-		/** The size of the font */ int size) {
-		if (fonts_.count(resource) > 0) {
-			return fonts_[resource];
+	/** loadImage, for callers holding the lock. Decodes bytes, if given and not empty,
+		instead of reading the file again. */
+	SDL_Surface* loadImageLocked(const std::string& resource, const std::vector<char>* bytes = NULL) {
+		SDL_Surface* image;
+		auto preloaded = preloadedImages_.find(resource);
+		if (preloaded != preloadedImages_.end()) {
+			image = preloaded->second;
+			preloadedImages_.erase(preloaded);
+		} else {
+			image = packedImage(resource);
+			if (image == NULL) {
+				image = bytes != NULL && !bytes->empty() ? decodeImage(*bytes) : decodeImage(resource);
+			}
+			if (image == NULL) {
+				return NULL;
+			}
+		}
+		SDL_Point size = { image->w, image->h };
+		auto known = imageSizes_.find(resource);
+		if (known != imageSizes_.end() && (known->second.x != size.x || known->second.y != size.y)) {
+			// Threads may have remembered the old size, or that the image couldn't be read.
+			generation_++;
+		}
+		imageSizes_[resource] = size;
+		return image;
+	}
+
+	/** getTextureRegion, for callers holding the lock */
+	TextureRegion getTextureRegionLocked(const std::string& resource, SDL_Renderer* ren) {
+		auto found = regions_.find(resource);
+		if (found != regions_.end()) {
+			textureBudget_.hit(resource);
+			return found->second;
+		}
+
+		std::vector<char> bytes;
+		const std::string& canonical = canonicalPath(resource, &bytes);
+		if (canonical != resource) {
+			return getTextureRegionLocked(canonical, ren);
+		}
+
+		TextureRegion region = { NULL, { 0, 0, 0, 0 } };
+		// Atlas pages are all in the native format, so images given another get their own texture.
+		if (!atlasEnabled_ || textures_.count(resource) > 0 || textureFormats_.count(resource) > 0) {
+			region.texture = getTextureLocked(resource, ren);
+			SDL_QueryTexture(region.texture, NULL, NULL, &region.rect.w, &region.rect.h);
+		} else {
+			SDL_Surface* image = loadImageLocked(resource, &bytes);
+			if (image == NULL) {
+				return region;
+			}
+			nativeFormat(ren);
+			if (!atlas_.insert(image, ren, region)) {
+				region.texture = createTexture(resource, image, ren);
+				region.rect = { 0, 0, image->w, image->h };
+			}
+			SDL_FreeSurface(image);
+		}
+
+		if (region.texture != NULL) {
+			regions_.insert(std::pair<std::string, TextureRegion>(resource, region));
+		}
+		return region;
+	}
+
+	/** getFont, for callers holding the lock */
+	TTF_Font* getFontLocked(const std::string& resource, int size) {
+		std::pair<std::string, int> key(resource, size);
+		auto found = fonts_.find(key);
+		if (found != fonts_.end()) {
+			fontBudget_.hit(resource);
+			return found->second;
 		}
 
-		TTF_Font* font = TTF_OpenFont(resource.c_str(), size);
+		std::vector<char> read;
+		const std::string& canonical = canonicalPath(resource, &read);
+		if (canonical != resource) {
+			return getFontLocked(canonical, size);
+		}
+
+		size_t bytes = 0;
+		const Uint8* packed = NULL;
+		const AssetPackEntry* entry = findPacked(resource, PACK_FILE, &packed);
+		TTF_Font* font = NULL;
+		if (entry != NULL) {
+			font = TTF_OpenFontRW(SDL_RWFromConstMem(packed, (int) entry->size), 1, size);
+			bytes = (size_t) entry->size;
+		} else {
+			const std::vector<char>* file = getFontFile(resource, read);
+			if (file != NULL) {
+				font = TTF_OpenFontRW(SDL_RWFromConstMem(file->data(), (int) file->size()), 1, size);
+				bytes = file->size();
+			}
+		}
 
 		if (font == NULL) {
 			SDL_Log("Failed to allocate font");
 		}
 		else {
 			SDL_Log("Allocating font");
-			fonts_.insert(std::pair<std::string, TTF_Font*>(resource, font));
+			fonts_.insert(std::pair<std::pair<std::string, int>, TTF_Font*>(key, font));
+			// Every size shares the file, so the font is budgeted by file.
+			fontBudget_.add(resource, bytes);
+			std::string victim;
+			while (fontBudget_.nextVictim(victim, resource)) {
+				auto first = fonts_.lower_bound(std::make_pair(victim, 0));
+				auto last = first;
+				for (; last != fonts_.end() && last->first.first == victim; ++last) {
+					TTF_CloseFont(last->second);
+				}
+				fonts_.erase(first, last);
+				fontFiles_.erase(victim);
+				fontBudget_.evicted(victim);
+			}
 			return font;
 		}
 
 		return NULL;
 	}
 
-	/** Returns a Mix_Music loaded using the given path */
-	Mix_Music* getMusic(/** The path for the music */ std::string resource) {
-		if (music_.count(resource) > 0) {
-			return music_[resource];
+	/** getMusic, for callers holding the lock */
+	Mix_Music* getMusicLocked(const std::string& resource) {
+		auto found = music_.find(resource);
+		if (found != music_.end()) {
+			musicBudget_.hit(resource);
+			return found->second;
 		}
 
-		Mix_Music* music = Mix_LoadMUS(resource.c_str());
+		const Uint8* packed = NULL;
+		const AssetPackEntry* entry = findPacked(resource, PACK_FILE, &packed);
+		auto preloaded = musicFiles_.find(resource);
+		Mix_Music* music;
+		size_t size;
+		if (preloaded != musicFiles_.end()) {
+			music = Mix_LoadMUS_RW(SDL_RWFromConstMem(preloaded->second.data(), (int) preloaded->second.size()), 1);
+			size = preloaded->second.size();
+		} else if (entry != NULL) {
+			music = Mix_LoadMUS_RW(SDL_RWFromConstMem(packed, (int) entry->size), 1);
+			size = (size_t) entry->size;
+		} else {
+			music = Mix_LoadMUS(resource.c_str());
+			size = fileSize(resource);
+		}
 
 		if (music == NULL) {
 			SDL_Log("Failed to allocate music");
+			musicFiles_.erase(resource);
 		}
 		else {
 			SDL_Log("Allocating music");
 			music_.insert(std::pair<std::string, Mix_Music*>(resource, music));
+			// Music streams, so the file size is the best measure of what it holds.
+			musicBudget_.add(resource, size);
+			std::string victim;
+			while (musicBudget_.nextVictim(victim, resource)) {
+				Mix_FreeMusic(music_[victim]);
+				music_.erase(victim);
+				musicFiles_.erase(victim);
+				musicBudget_.evicted(victim);
+			}
 			return music;
 		}
 
 		return NULL;
 	}
 
-	/** Returns a playable sound chunk from the given resource path */
-	Mix_Chunk* getSFX(/** The resource path */std::string resource) {
-		if (sounds_.count(resource) > 0) {
-			return sounds_[resource];
+	/** getSFX, for callers holding the lock */
+	Mix_Chunk* getSFXLocked(const std::string& resource) {
+		auto found = sounds_.find(resource);
+		if (found != sounds_.end()) {
+			soundBudget_.hit(resource);
+			return found->second;
+		}
+
+		std::vector<char> bytes;
+		const std::string& canonical = canonicalPath(resource, &bytes);
+		if (canonical != resource) {
+			return getSFXLocked(canonical);
 		}
 
-		Mix_Chunk* sfx = Mix_LoadWAV(resource.c_str());
+		Mix_Chunk* sfx = packedSFX(resource);
+		if (sfx == NULL) {
+			sfx = !bytes.empty()
+				? Mix_LoadWAV_RW(SDL_RWFromConstMem(bytes.data(), (int) bytes.size()), 1)
+				: Mix_LoadWAV(resource.c_str());
+		}
 
 		if (sfx == NULL) {
 			SDL_Log("Failed to allocate sfx");
@@ -144,28 +1184,663 @@ public:
 		else {
 			SDL_Log("Allocating sfx");
 			sounds_.insert(std::pair<std::string, Mix_Chunk*>(resource, sfx));
+			trackSFX(resource, sfx);
 			return sfx;
 		}
 
 		return NULL;
 	}
 
-    static void reset() {
-        delete inst_;
-        inst_ = NULL;
-    }
+	/** Returns the bytes of the given font file, taking them from bytes if it was just
+		read and otherwise reading it the first time */
+	const std::vector<char>* getFontFile(std::string resource, std::vector<char>& bytes) {
+		auto found = fontFiles_.find(resource);
+		if (found != fontFiles_.end()) {
+			return &found->second;
+		}
 
-private:
-	/** Private constructor */
-    ResourceManager() {}
+		if (bytes.empty() && !readFile(resource, bytes)) {
+			return NULL;
+		}
+		return &fontFiles_.insert(std::make_pair(resource, std::move(bytes))).first->second;
+	}
+
+	/** Returns the path resource is cached under if it is known to be an alias, or else
+		resource. Reads nothing, so callers may hold the lock shared. */
+	const std::string& cachedPath(const std::string& resource) const {
+		auto alias = aliases_.find(resource);
+		return alias != aliases_.end() ? alias->second : resource;
+	}
+
+	/** Returns the path resources with the same contents as resource are cached under.
+		The first path loaded with some contents owns them; later paths become aliases.
+		If the file has to be read to hash it, its contents go in bytes for the loader. */
+	const std::string& canonicalPath(const std::string& resource, std::vector<char>* bytes = NULL) {
+		auto known = aliases_.find(resource);
+		if (known != aliases_.end()) {
+			return known->second;
+		}
+
+		const Uint8* packed = NULL;
+		const AssetPackEntry* entry = findPacked(resource, PACK_FILE, &packed);
+		if (entry == NULL) {
+			entry = findPacked(resource, PACK_IMAGE, &packed);
+		}
+		if (entry != NULL) {
+			return registerContent(resource, ContentHash::hash(packed, (size_t) entry->size), (size_t) entry->size);
+		}
+
+		std::vector<char> read;
+		std::vector<char>& file = bytes != NULL ? *bytes : read;
+		if (!readFile(resource, file)) {
+			// Leave missing files to fail in their loaders.
+			file.clear();
+			return aliases_.insert(std::make_pair(resource, resource)).first->second;
+		}
+		return registerContent(resource, ContentHash::hash(file.data(), file.size()), file.size());
+	}
+
+	/** Records what resource contains, returning the path those contents are cached under */
+	const std::string& registerContent(const std::string& resource, Uint64 hash, size_t size) {
+		auto known = aliases_.find(resource);
+		if (known != aliases_.end()) {
+			return known->second;
+		}
+
+		std::pair<Uint64, size_t> content(hash, size);
+		auto owner = contentPaths_.find(content);
+		if (owner == contentPaths_.end()) {
+			contentPaths_.insert(std::make_pair(content, resource));
+			return aliases_.insert(std::make_pair(resource, resource)).first->second;
+		}
+
+		SDL_Log("%s has the same contents as %s, sharing it", resource.c_str(), owner->second.c_str());
+		dedupedPaths_++;
+		dedupedBytes_ += size;
+		return aliases_.insert(std::make_pair(resource, owner->second)).first->second;
+	}
+
+	/** Forgets what a changed file contained. A path sharing another's resource stops
+		sharing it, and paths sharing this one's load their own files again. Returns
+		whether resource has anything cached under it to reload. */
+	bool forgetContent(const std::string& resource) {
+		auto alias = aliases_.find(resource);
+		if (alias != aliases_.end() && alias->second != resource) {
+			aliases_.erase(alias);
+			generation_++;
+			return false;
+		}
+		for (auto it = aliases_.begin(); it != aliases_.end(); ) {
+			if (it->second == resource && it->first != resource) {
+				it = aliases_.erase(it);
+				generation_++;
+			} else {
+				++it;
+			}
+		}
+		for (auto it = contentPaths_.begin(); it != contentPaths_.end(); ) {
+			if (it->second == resource) {
+				it = contentPaths_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		auto font = fonts_.lower_bound(std::make_pair(resource, 0));
+		return imageSizes_.count(resource) > 0 || textures_.count(resource) > 0 || regions_.count(resource) > 0
+			|| sounds_.count(resource) > 0 || fontFiles_.count(resource) > 0
+			|| (font != fonts_.end() && font->first.first == resource);
+	}
+
+	/** Decodes a changed image and copies it over its textures */
+	bool reloadImage(const std::string& resource, const std::vector<char>& bytes,
+		std::function<void(const std::string&, SDL_Surface*)> imageReloaded) {
+		SDL_Surface* image = decodeImage(bytes);
+		if (image == NULL) {
+			return false;
+		}
+		SDL_Point size = { image->w, image->h };
+		SDL_Point old = imageSizes_.count(resource) > 0 ? imageSizes_[resource] : size;
+		bool resized = size.x != old.x || size.y != old.y;
+		imageSizes_[resource] = size;
+		if (resized) {
+			for (auto it = frameRects_.begin(); it != frameRects_.end(); ) {
+				if (std::get<0>(it->first) == resource) {
+					it = frameRects_.erase(it);
+				} else {
+					++it;
+				}
+			}
+			generation_++;
+		}
+
+		destroyMips(resource);
+		textureBudget_.invalidate(resource);
+		auto texture = textures_.find(resource);
+		auto region = regions_.find(resource);
+		bool ownTexture = texture != textures_.end();
+		if (region != regions_.end() && (!ownTexture || region->second.texture != texture->second)) {
+			// Packed into an atlas page. A new size needs a new cell, so it is packed again when next drawn.
+			if (resized || !updateTexture(region->second.texture, &region->second.rect, image)) {
+				regions_.erase(region);
+				generation_++;
+			}
+		}
+		if (ownTexture && (resized || !updateTexture(texture->second, NULL, image))) {
+			SDL_DestroyTexture(texture->second);
+			textures_.erase(texture);
+			regions_.erase(resource);
+			textureBudget_.remove(resource);
+		} else if (ownTexture) {
+			// The texture was updated in place, so its levels are built again from the new image.
+			buildMips(resource, image, formatRenderer_);
+		}
+
+		imageReloaded(resource, image);
+		auto external = externalTextures_.find(resource);
+		if (external != externalTextures_.end() && resized) {
+			textureBudget_.resize(resource, (size_t) external->second * size.x * size.y);
+			evictTextures(resource);
+		}
+		auto preloaded = preloadedImages_.find(resource);
+		if (preloaded != preloadedImages_.end()) {
+			SDL_FreeSurface(preloaded->second);
+			preloaded->second = image;
+		} else {
+			SDL_FreeSurface(image);
+		}
+		return true;
+	}
+
+	/** Copies an image into part of a texture, converting it to the texture's format */
+	static bool updateTexture(SDL_Texture* texture, const SDL_Rect* rect, SDL_Surface* image) {
+		Uint32 format = 0;
+		SDL_QueryTexture(texture, &format, NULL, NULL, NULL);
+		// Converting to a format with alpha turns the color key into transparent pixels.
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(image, format, 0);
+		if (converted == NULL) {
+			return false;
+		}
+		bool updated = SDL_UpdateTexture(texture, rect, converted->pixels, converted->pitch) == 0;
+		SDL_FreeSurface(converted);
+		return updated;
+	}
+
+	/** Decodes a changed sound and replaces the cached one */
+	bool reloadSFX(const std::string& resource, const std::vector<char>& bytes) {
+		auto found = sounds_.find(resource);
+		if (found == sounds_.end()) {
+			return false;
+		}
+		Mix_Chunk* sfx = Mix_LoadWAV_RW(SDL_RWFromConstMem(bytes.data(), (int) bytes.size()), 1);
+		if (sfx == NULL) {
+			SDL_Log("Failed to allocate sfx");
+			return false;
+		}
+		// Freeing a chunk stops any channel playing it, so the old one lives until they finish.
+		retiredSounds_.push_back(found->second);
+		found->second = sfx;
+		freeRetiredSounds();
+		soundBudget_.remove(resource);
+		soundBudget_.add(resource, sfx->alen);
+		generation_++;
+		return true;
+	}
+
+	/** Opens every loaded size of a changed font from its new file */
+	bool reloadFont(const std::string& resource, std::vector<char>& bytes,
+		std::function<void(TTF_Font*, TTF_Font*)> fontReplaced) {
+		auto first = fonts_.lower_bound(std::make_pair(resource, 0));
+		std::vector<TTF_Font*> opened;
+		for (auto it = first; it != fonts_.end() && it->first.first == resource; ++it) {
+			TTF_Font* font = TTF_OpenFontRW(SDL_RWFromConstMem(bytes.data(), (int) bytes.size()), 1, it->first.second);
+			if (font == NULL) {
+				SDL_Log("Failed to allocate font");
+				for (size_t i = 0; i < opened.size(); i++) {
+					TTF_CloseFont(opened[i]);
+				}
+				return false;
+			}
+			opened.push_back(font);
+		}
+
+		size_t i = 0;
+		for (auto it = first; it != fonts_.end() && it->first.first == resource; ++it, ++i) {
+			fontReplaced(it->second, opened[i]);
+			TTF_CloseFont(it->second);
+			it->second = opened[i];
+		}
+		// The old fonts read from the old bytes, so they go only once those fonts are closed.
+		fontBudget_.remove(resource);
+		fontBudget_.add(resource, bytes.size());
+		fontFiles_[resource] = std::move(bytes);
+		generation_++;
+		return true;
+	}
+
+	/** Returns one row of getCacheStats */
+	static std::tuple<std::string, size_t, size_t, int, int, int, int> statsOf(std::string kind,
+		const CacheBudget<std::string>& budget) {
+		return std::make_tuple(kind, budget.getBytes(), budget.getBudget(), budget.getEntries(),
+			budget.getHits(), budget.getMisses(), budget.getEvictions());
+	}
+
+	/** Returns the size of a file, or 0 if it can't be opened */
+	static size_t fileSize(const std::string& resource) {
+		SDL_RWops* rw = SDL_RWFromFile(resource.c_str(), "rb");
+		if (rw == NULL) {
+			return 0;
+		}
+		Sint64 size = SDL_RWsize(rw);
+		SDL_RWclose(rw);
+		return size > 0 ? (size_t) size : 0;
+	}
+
+	/** Returns the newest open pack's entry of the given kind for a resource, or NULL */
+	const AssetPackEntry* findPacked(const std::string& resource, Uint32 kind, const Uint8** data = NULL) {
+		for (auto it = packs_.rbegin(); it != packs_.rend(); ++it) {
+			const AssetPackEntry* entry = (*it)->find(resource, kind);
+			if (entry != NULL) {
+				if (data != NULL) {
+					*data = (*it)->data(*entry);
+				}
+				return entry;
+			}
+		}
+		return NULL;
+	}
+
+	/** Wraps a packed image's pixels in a surface without copying them, or returns NULL */
+	SDL_Surface* packedImage(const std::string& resource) {
+		const Uint8* pixels = NULL;
+		const AssetPackEntry* entry = findPacked(resource, PACK_IMAGE, &pixels);
+		if (entry == NULL) {
+			return NULL;
+		}
+		// Surfaces never write to pixels they are given, so the read-only mapping is safe.
+		return SDL_CreateRGBSurfaceWithFormatFrom(const_cast<Uint8*>(pixels), (int) entry->width, (int) entry->height,
+			SDL_BITSPERPIXEL(entry->format), (int) entry->pitch, entry->format);
+	}
+
+	/** Loads a packed sound effect, or returns NULL if no pack has it */
+	Mix_Chunk* packedSFX(const std::string& resource) {
+		const Uint8* data = NULL;
+		const AssetPackEntry* pcm = findPacked(resource, PACK_PCM, &data);
+		int frequency = 0;
+		Uint16 format = 0;
+		int channels = 0;
+		if (pcm != NULL && Mix_QuerySpec(&frequency, &format, &channels) != 0 && (int) pcm->width == frequency
+			&& pcm->format == format && (int) pcm->height == channels) {
+			// Already in the mixer's format, so it plays straight from the mapping.
+			return Mix_QuickLoad_RAW(const_cast<Uint8*>(data), (Uint32) pcm->size);
+		}
+
+		const AssetPackEntry* file = findPacked(resource, PACK_FILE, &data);
+		if (file != NULL) {
+			return Mix_LoadWAV_RW(SDL_RWFromConstMem(data, (int) file->size), 1);
+		}
+		return NULL;
+	}
+
+	/** A resource being preloaded, and what it decoded to */
+	struct Preloaded {
+		/** The resource path */
+		std::string resource;
+		/** What kind of resource it is */
+		PreloadType type;
+		/** The batch it belongs to */
+		std::shared_ptr<PreloadProgress> progress;
+		/** The decoded image */
+		SDL_Surface* surface = NULL;
+		/** The decoded sound */
+		Mix_Chunk* chunk = NULL;
+		/** The font file, or the music file */
+		std::vector<char> bytes;
+		/** Whether decoding worked */
+		bool ok = false;
+		/** Whether hash and size describe the file's contents */
+		bool hashed = false;
+		/** The hash of the file's contents */
+		Uint64 hash = 0;
+		/** The size of the file */
+		size_t size = 0;
+	};
+
+	/** Whether a resource is already cached, so preloading it again would be wasted */
+	bool isLoaded(const Preloaded& job) {
+		switch (job.type) {
+			case PRELOAD_FONT:
+				return fontFiles_.count(job.resource) > 0;
+			case PRELOAD_SOUND:
+				return sounds_.count(job.resource) > 0;
+			default:
+				return textures_.count(job.resource) > 0 || regions_.count(job.resource) > 0;
+		}
+	}
+
+	/** Whether a preloaded sound is long enough to be music rather than a sound effect */
+	static bool isMusic(const Preloaded& job) {
+		return job.type == PRELOAD_SOUND && (Sint64) job.size > MAX_DECODED_AUDIO;
+	}
+
+	/** Decodes a preloaded resource. Runs on a worker thread, so touches nothing shared. */
+	static void decode(Preloaded& job) {
+		if (!readFile(job.resource, job.bytes)) {
+			return;
+		}
+		// Hashing here spares the main thread from reading the file again to find duplicates.
+		job.hash = ContentHash::hash(job.bytes.data(), job.bytes.size());
+		job.size = job.bytes.size();
+		job.hashed = true;
+
+		switch (job.type) {
+			case PRELOAD_FONT:
+				job.ok = true;
+				break;
+			case PRELOAD_SOUND:
+				if (isMusic(job)) {
+					// Music streams from its bytes when it plays, so they are all it needs.
+					job.ok = true;
+					return;
+				}
+				job.chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(job.bytes.data(), (int) job.bytes.size()), 1);
+				job.ok = job.chunk != NULL;
+				break;
+			default:
+				job.surface = decodeImage(job.bytes);
+				job.ok = job.surface != NULL;
+				break;
+		}
+		if (job.type != PRELOAD_FONT) {
+			std::vector<char>().swap(job.bytes);
+		}
+	}
+
+	/** Puts a decoded resource in its cache, or queues an image for upload */
+	void store(Preloaded& job) {
+		if (!job.ok) {
+			SDL_Log("Failed to preload %s", job.resource.c_str());
+			job.progress->failed++;
+			return;
+		}
+		const std::string& canonical = job.hashed
+			? registerContent(job.resource, job.hash, job.size)
+			: canonicalPath(job.resource);
+		if (canonical != job.resource) {
+			// A copy of something already loaded or preloaded; it will share that.
+			SDL_FreeSurface(job.surface);
+			if (job.chunk != NULL) {
+				Mix_FreeChunk(job.chunk);
+			}
+			job.progress->loaded++;
+			return;
+		}
+
+		if (job.type == PRELOAD_IMAGE) {
+			auto existing = preloadedImages_.find(job.resource);
+			if (existing != preloadedImages_.end()) {
+				// The same image was preloaded twice.
+				SDL_FreeSurface(existing->second);
+			}
+			preloadedImages_[job.resource] = job.surface;
+			job.surface = NULL;
+			pendingUploads_.push_back(job);
+			return;
+		}
+
+		if (isMusic(job)) {
+			if (music_.count(job.resource) == 0) {
+				musicFiles_[job.resource] = std::move(job.bytes);
+				getMusicLocked(job.resource);
+			}
+		} else if (job.type == PRELOAD_SOUND) {
+			if (sounds_.insert(std::pair<std::string, Mix_Chunk*>(job.resource, job.chunk)).second) {
+				trackSFX(job.resource, job.chunk);
+			} else {
+				Mix_FreeChunk(job.chunk);
+			}
+		} else {
+			fontFiles_.insert(std::make_pair(job.resource, std::move(job.bytes)));
+		}
+		job.progress->loaded++;
+	}
+
+	/** Creates and caches a texture for an image returned by loadImage */
+	SDL_Texture* createTexture(std::string resource, SDL_Surface* image, SDL_Renderer* ren) {
+		SDL_Log("Allocating memory for texture");
+		// Create a texture from our surface
+		// Textures run faster and take advantage of hardware acceleration
+		SDL_Texture* texture = uploadSurface(image, textureFormatFor(resource, ren), ren);
+		if (texture == NULL) {
+			return NULL;
+		}
+		textures_.insert(std::pair<std::string, SDL_Texture*>(resource, texture));
+		trackTexture(resource, texture);
+		// The image is already decoded, so its levels are made now rather than decoding it again later.
+		buildMips(resource, image, ren);
+		return texture;
+	}
+
+	/** Creates a texture in the given format from an image, converting it first if needed.
+		Doing the conversion here means the renderer never has to pick one itself. */
+	static SDL_Texture* uploadSurface(SDL_Surface* image, Uint32 format, SDL_Renderer* ren) {
+		bool transparent = SDL_ISPIXELFORMAT_ALPHA(image->format->format) || SDL_HasColorKey(image);
+		SDL_Surface* converted = image;
+		if (image->format->format != format || SDL_HasColorKey(image)) {
+			// Converting to a format with alpha turns the color key into transparent pixels.
+			converted = SDL_ConvertSurfaceFormat(image, format, 0);
+			if (converted == NULL) {
+				SDL_Log("Failed to convert surface");
+				return NULL;
+			}
+		}
+		SDL_Texture* texture = SDL_CreateTexture(ren, format, SDL_TEXTUREACCESS_STATIC, converted->w, converted->h);
+		if (texture == NULL) {
+			SDL_Log("Failed to create texture");
+		} else {
+			SDL_UpdateTexture(texture, NULL, converted->pixels, converted->pitch);
+			// Opaque images skip blending, as SDL_CreateTextureFromSurface would do.
+			bool blend = transparent && SDL_ISPIXELFORMAT_ALPHA(format);
+			SDL_SetTextureBlendMode(texture, blend ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+		}
+		if (converted != image) {
+			SDL_FreeSurface(converted);
+		}
+		return texture;
+	}
+
+	/** Returns the format the renderer stores textures in without converting them, picking
+		the first it lists with alpha so color keys become real transparency */
+	Uint32 nativeFormat(SDL_Renderer* ren) {
+		if (ren != formatRenderer_) {
+			formatRenderer_ = ren;
+			nativeFormat_ = SDL_PIXELFORMAT_ARGB8888;
+			SDL_RendererInfo info;
+			if (SDL_GetRendererInfo(ren, &info) == 0) {
+				for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+					Uint32 format = info.texture_formats[i];
+					if (SDL_ISPIXELFORMAT_ALPHA(format) && !SDL_ISPIXELFORMAT_FOURCC(format)) {
+						nativeFormat_ = format;
+						break;
+					}
+				}
+			}
+			atlas_.setFormat(nativeFormat_);
+		}
+		return nativeFormat_;
+	}
+
+	/** Returns the format to create an image's texture in: the one chosen with
+		setTextureFormat if the renderer supports it, or else the native format */
+	Uint32 textureFormatFor(const std::string& resource, SDL_Renderer* ren) {
+		Uint32 native = nativeFormat(ren);
+		auto chosen = textureFormats_.find(resource);
+		if (chosen == textureFormats_.end()) {
+			return native;
+		}
+		SDL_RendererInfo info;
+		if (SDL_GetRendererInfo(ren, &info) == 0) {
+			for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+				if (info.texture_formats[i] == chosen->second) {
+					return chosen->second;
+				}
+			}
+		}
+		// The renderer would convert it back, so it would save no memory.
+		SDL_Log("The renderer doesn't support %s for %s", SDL_GetPixelFormatName(chosen->second), resource.c_str());
+		return native;
+	}
+
+	/** Builds every mip level of an image with a texture from the decoded image, in the
+		texture's format. Images loaded with mipmaps off get an empty chain. */
+	void buildMips(const std::string& resource, SDL_Surface* image, SDL_Renderer* ren) {
+		auto chain = mips_.insert(std::make_pair(resource, std::vector<SDL_Texture*>())).first;
+		auto texture = textures_.find(resource);
+		if (!mipmapsEnabled_ || texture == textures_.end()) {
+			return;
+		}
+		Uint32 format = 0;
+		int w = 0;
+		int h = 0;
+		SDL_QueryTexture(texture->second, &format, NULL, &w, &h);
+		if (MipChain::levels(w, h) == 0) {
+			return;
+		}
+		// Converting to a format with alpha turns the color key into transparent pixels.
+		SDL_Surface* level = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_ARGB8888, 0);
+
+		size_t bytes = (size_t) SDL_BYTESPERPIXEL(format) * w * h;
+		for (int i = MipChain::levels(w, h); i > 0 && level != NULL; i--) {
+			SDL_Surface* half = MipChain::halve(level);
+			SDL_FreeSurface(level);
+			level = half;
+			SDL_Texture* mip = level != NULL ? uploadSurface(level, format, ren) : NULL;
+			if (mip == NULL) {
+				break;
+			}
+			chain->second.push_back(mip);
+			bytes += (size_t) SDL_BYTESPERPIXEL(format) * level->w * level->h;
+		}
+		SDL_FreeSurface(level);
+
+		// The levels live and die with the image, so they count towards its budget.
+		textureBudget_.resize(resource, bytes);
+		evictTextures(resource);
+	}
+
+	/** Frees the mip levels of an image, if it has any. They are cached under the
+		image's texture, so the caller changes its version. */
+	void destroyMips(const std::string& resource) {
+		auto chain = mips_.find(resource);
+		if (chain == mips_.end()) {
+			return;
+		}
+		for (size_t i = 0; i < chain->second.size(); i++) {
+			SDL_DestroyTexture(chain->second[i]);
+		}
+		mips_.erase(chain);
+	}
+
+	/** Counts a new texture against the texture budget, evicting old ones if needed */
+	void trackTexture(const std::string& resource, SDL_Texture* texture) {
+		Uint32 format = 0;
+		int w = 0;
+		int h = 0;
+		SDL_QueryTexture(texture, &format, NULL, &w, &h);
+		textureBudget_.add(resource, (size_t) SDL_BYTESPERPIXEL(format) * w * h);
+		evictTextures(resource);
+	}
+
+	/** Frees the least recently used textures until they are back under budget, keeping
+		the one just added or resized, which the caller is about to use */
+	void evictTextures(const std::string& resource) {
+		std::string victim;
+		while (textureBudget_.nextVictim(victim, resource)) {
+			auto evicted = textures_.find(victim);
+			if (evicted == textures_.end()) {
+				// Kept by another renderer, which frees it once trackExternalTexture hands it back.
+				externalTextures_.erase(victim);
+				externalEvictions_.push_back(victim);
+				textureBudget_.evicted(victim);
+				continue;
+			}
+			SDL_DestroyTexture(evicted->second);
+			textures_.erase(evicted);
+			regions_.erase(victim);
+			destroyMips(victim);
+			textureBudget_.evicted(victim);
+		}
+	}
+
+	/** Counts a new sound against the sound budget, evicting old ones if needed. Sounds
+		still playing are kept, since freeing a chunk would cut it off, so the budget may
+		stay exceeded until they finish. */
+	void trackSFX(const std::string& resource, Mix_Chunk* sfx) {
+		soundBudget_.add(resource, sfx->alen);
+		std::set<Mix_Chunk*> playing = playingChunks();
+		std::string victim;
+		while (soundBudget_.nextVictim(victim, resource, [this, &playing](const std::string& key) {
+			return playing.count(sounds_[key]) > 0;
+		})) {
+			Mix_FreeChunk(sounds_[victim]);
+			sounds_.erase(victim);
+			soundBudget_.evicted(victim);
+		}
+		freeRetiredSounds();
+	}
+
+	/** Returns the chunks some channel is playing */
+	static std::set<Mix_Chunk*> playingChunks() {
+		std::set<Mix_Chunk*> playing;
+		int channels = Mix_AllocateChannels(-1);
+		for (int i = 0; i < channels; i++) {
+			if (Mix_Playing(i)) {
+				playing.insert(Mix_GetChunk(i));
+			}
+		}
+		return playing;
+	}
+
+	/** Frees the reloaded sounds' old chunks that have finished playing */
+	void freeRetiredSounds() {
+		if (retiredSounds_.empty()) {
+			return;
+		}
+		std::set<Mix_Chunk*> playing = playingChunks();
+		for (auto it = retiredSounds_.begin(); it != retiredSounds_.end();) {
+			if (playing.count(*it) == 0) {
+				Mix_FreeChunk(*it);
+				it = retiredSounds_.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
 
 	/** Private destructor */
     ~ResourceManager() {
+		// Let the workers finish before freeing what they decoded.
+		pool_.reset();
+		for (auto it = decoded_.begin(); it != decoded_.end(); ++it) {
+			SDL_FreeSurface(it->surface);
+			if (it->chunk != NULL) {
+				Mix_FreeChunk(it->chunk);
+			}
+		}
+		for (auto it = preloadedImages_.begin(); it != preloadedImages_.end(); ++it) {
+			SDL_FreeSurface(it->second);
+		}
+
         for (auto it=textures_.begin(); it!=textures_.end(); ++it) {
             SDL_DestroyTexture(it->second);
             //SDL_Log("Freed Texture: %s", it->first);
         }
 
+		for (auto it = mips_.begin(); it != mips_.end(); ++it) {
+			for (size_t i = 0; i < it->second.size(); i++) {
+				SDL_DestroyTexture(it->second[i]);
+			}
+		}
+
 		for (auto it = music_.begin(); it != music_.end(); ++it) {
 			Mix_FreeMusic(it->second);
 			//SDL_Log("Freed Music: %s", it->first);
@@ -175,6 +1850,9 @@ private:
 			Mix_FreeChunk(it->second);
 			//SDL_Log("Freed SFX: %s", it->first);
 		}
+		for (size_t i = 0; i < retiredSounds_.size(); i++) {
+			Mix_FreeChunk(retiredSounds_[i]);
+		}
 
 		for (auto it = fonts_.begin(); it != fonts_.end(); ++it) {
 			TTF_CloseFont(it->second);
@@ -183,16 +1861,95 @@ private:
     }
 
 	/** The singleton instance */
-	static ResourceManager* inst_;
+	static std::atomic<ResourceManager*> inst_;
+	/** Guards creating and freeing the instance */
+	static std::mutex instMutex_;
+	/** How many instances have been created */
+	static std::atomic<Uint32> instances_;
+	/** Tells this instance from earlier ones, which threads may still have caches of */
+	const Uint32 id_;
+	/** Guards everything below. Lookups that find what they want share it, so
+		threads only wait on each other while something is loaded or changed. */
+	mutable std::shared_timed_mutex mutex_;
 
 	/** Mapping of cached SDL_Textures */
   std::map<std::string, SDL_Texture*> textures_;
+	/** The mip levels of images drawn much smaller than they are, from level 1 down */
+	std::map<std::string, std::vector<SDL_Texture*>> mips_;
+	/** Mapping of images to the texture regions they are drawn from */
+	std::map<std::string, TextureRegion> regions_;
+	/** The width and height of every image loaded so far */
+	std::map<std::string, SDL_Point> imageSizes_;
+	/** Frame rectangles of sprite sheets by path, frame width and frame height */
+	std::map<std::tuple<std::string, int, int>, std::vector<SDL_Rect>, TupleLess> frameRects_;
+	/** Pixel formats chosen with setTextureFormat */
+	std::map<std::string, Uint32> textureFormats_;
+	/** The renderer nativeFormat_ was found for */
+	SDL_Renderer* formatRenderer_ = NULL;
+	/** The renderer's preferred texture format */
+	Uint32 nativeFormat_ = SDL_PIXELFORMAT_ARGB8888;
+	/** Whether images loaded from now on get mip levels */
+	bool mipmapsEnabled_ = true;
+	/** Whether small images are packed into the atlas */
+	bool atlasEnabled_ = false;
+	/** The shared pages small images are packed into */
+	TextureAtlas atlas_;
 	/** Mapping of cached Mix_Music */
 	std::map<std::string, Mix_Music*> music_;
 	/** Mapping of cached Mix_Chunk */
 	std::map<std::string, Mix_Chunk*> sounds_;
-	/** Mapping of cached TTF_Font */
-	std::map<std::string, TTF_Font*> fonts_;
+	/** Chunks replaced by reloads while channels were playing them, freed once they finish */
+	std::vector<Mix_Chunk*> retiredSounds_;
+	/** Mapping of cached TTF_Font by path and size */
+	std::map<std::pair<std::string, int>, TTF_Font*> fonts_;
+	/** The bytes of every font file, shared by all sizes of the font. Must outlive fonts_. */
+	std::map<std::string, std::vector<char>> fontFiles_;
+	/** The bytes of preloaded music, which it streams from. Must outlive music_. */
+	std::map<std::string, std::vector<char>> musicFiles_;
+
+	/** The bytes per pixel of each texture another renderer keeps, by path */
+	std::map<std::string, int> externalTextures_;
+	/** The paths of textures other renderers keep that were evicted, until they are told */
+	std::vector<std::string> externalEvictions_;
+
+	/** Keeps textures_ and other renderers' textures under budget. Atlas pages aren't in it. */
+	CacheBudget<std::string> textureBudget_;
+	/** Keeps music_ under budget */
+	CacheBudget<std::string> musicBudget_;
+	/** Keeps sounds_ under budget */
+	CacheBudget<std::string> soundBudget_;
+	/** Keeps fonts_ and fontFiles_ under budget, by font file */
+	CacheBudget<std::string> fontBudget_;
+	/** The path each resource path is cached under, itself unless its contents were seen first elsewhere */
+	std::map<std::string, std::string> aliases_;
+	/** The owning path of every (hash, size) of contents loaded so far */
+	std::map<std::pair<Uint64, size_t>, std::string> contentPaths_;
+	/** How many paths turned out to be aliases */
+	int dedupedPaths_ = 0;
+	/** The file bytes aliases saved loading again */
+	size_t dedupedBytes_ = 0;
+	/** Changes whenever a resource that was handed out is freed or replaced */
+	std::atomic<Uint32> generation_{0};
+	/** Guards threadCaches_ */
+	std::mutex threadCachesMutex_;
+	/** Every thread's cache of this instance's lookups */
+	std::vector<std::unique_ptr<ThreadCache>> threadCaches_;
+
+	/** Open asset packs, oldest first. Sounds, music and fonts loaded from them point into
+		the mappings, so the destructor frees those before the packs are unmapped. */
+	std::vector<std::unique_ptr<AssetPack>> packs_;
+	/** Watches resource directories for changes. Created by the first watch. */
+	std::unique_ptr<FileWatcher> watcher_;
+	/** Decodes preloaded resources. Created by the first preload. */
+	std::unique_ptr<ThreadPool> pool_;
+	/** Guards decoded_, which the workers add to */
+	std::mutex preloadMutex_;
+	/** Resources the workers have finished with, waiting to be stored */
+	std::deque<Preloaded> decoded_;
+	/** Decoded images waiting for a texture, in the order they were preloaded */
+	std::deque<Preloaded> pendingUploads_;
+	/** Decoded images not yet turned into textures, taken by loadImage */
+	std::map<std::string, SDL_Surface*> preloadedImages_;
 };
 
 #endif
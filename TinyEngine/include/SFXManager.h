@@ -4,28 +4,43 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
 #include <string.h>
+#include <atomic>
+#include <mutex>
 #include "ResourceManager.h"
 
 /** Manager for Sound Effects and Music */
 class SFXManager {
 public:
 
-	/** Gets the instance of the SFXManager */
+	/** Gets the instance of the SFXManager. Safe to call from any thread. */
 	static SFXManager& instance() {
-		if (sfxInstance == nullptr) {
-			sfxInstance = new SFXManager();
-			if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
-			{
-				SDL_Log("Error opening mixer in SFXManager");
+		SFXManager* inst = sfxInstance.load(std::memory_order_acquire);
+		if (inst == nullptr) {
+			std::lock_guard<std::mutex> lock(instanceMutex);
+			inst = sfxInstance.load(std::memory_order_relaxed);
+			if (inst == nullptr) {
+				inst = new SFXManager();
+				if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
+				{
+					SDL_Log("Error opening mixer in SFXManager");
+				}
+				sfxInstance.store(inst, std::memory_order_release);
 			}
 		}
-		return *sfxInstance;
+		return *inst;
 	}
 
 	/** Plays music at the given path */
 	void playMusic(/** The path to the song */ std::string song) {
+		std::lock_guard<std::mutex> lock(musicMutex);
 		music = NULL;
 		ResourceManager& resourceManager = ResourceManager::instance();
+		// The song being played must not be evicted.
+		resourceManager.pin(song);
+		if (!musicPath.empty()) {
+			resourceManager.unpin(musicPath);
+		}
+		musicPath = song;
 		music = resourceManager.getMusic(song);
 		Mix_PlayMusic(music, -1);
 
@@ -38,8 +53,14 @@ public:
 		Mix_PlayChannel(-1, sfx, 0);
 	}
 
+	/** Play a sound effect that has already been loaded */
+	void playSFX(/** The sound effect */ Mix_Chunk* sfx) {
+		Mix_PlayChannel(-1, sfx, 0);
+	}
+
 	/** Toggles whether or not the music is playing */
 	void toggleMusic() {
+		std::lock_guard<std::mutex> lock(musicMutex);
 		if (Mix_PlayingMusic() == 0)
 		{
 			//Play the music
@@ -80,9 +101,15 @@ private:
 	~SFXManager() {}
 
 	/** The current instance of the SFXManager */
-	static SFXManager* sfxInstance;
+	static std::atomic<SFXManager*> sfxInstance;
+	/** Guards creating the instance */
+	static std::mutex instanceMutex;
+	/** Guards music and musicPath */
+	std::mutex musicMutex;
 	/** The current Mix_Music playing the background music */
-	Mix_Music* music;
+	Mix_Music* music = NULL;
+	/** The path of the background music */
+	std::string musicPath;
 };
 
 #endif
@@ -0,0 +1,132 @@
+#ifndef SKYLINE_PACKER_H
+#define SKYLINE_PACKER_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+/** Packs rectangles into a fixed size area using the bottom-left skyline heuristic.
+	The skyline is the list of horizontal segments forming the top edge of
+	everything placed so far; new rectangles sit on the lowest segment they fit on. */
+class SkylinePacker {
+public:
+	/** Creates an empty packer for an area of the given size */
+	SkylinePacker(/** The width of the area */ int w, /** The height of the area */ int h)
+		: width(w), height(h) {
+		Segment floor = { 0, 0, w };
+		skyline.push_back(floor);
+	}
+
+	/** Finds room for a w by h rectangle. Returns false if the area is too full. */
+	bool insert(/** The rectangle width */ int w, /** The rectangle height */ int h,
+		/** Receives the upper left corner of the placed rectangle */ SDL_Point& position) {
+		int bestIndex = -1;
+		int bestTop = height + 1;
+		int bestWidth = width + 1;
+		int bestY = 0;
+
+		for (size_t i = 0; i < skyline.size(); i++) {
+			int y;
+			if (!fits(i, w, h, y)) {
+				continue;
+			}
+			if (y + h < bestTop || (y + h == bestTop && skyline[i].width < bestWidth)) {
+				bestIndex = (int) i;
+				bestTop = y + h;
+				bestWidth = skyline[i].width;
+				bestY = y;
+			}
+		}
+
+		if (bestIndex < 0) {
+			return false;
+		}
+
+		position.x = skyline[bestIndex].x;
+		position.y = bestY;
+		addSegment(bestIndex, position.x, bestY + h, w);
+		usedArea += w * h;
+		return true;
+	}
+
+	/** Returns the number of pixels covered by placed rectangles */
+	int getUsedArea() const {
+		return usedArea;
+	}
+
+	/** Returns the total number of pixels in the area */
+	int getTotalArea() const {
+		return width * height;
+	}
+
+private:
+	/** A horizontal piece of the skyline */
+	struct Segment {
+		int x, y, width;
+	};
+
+	/** Checks whether a w by h rectangle can sit with its left edge on segment i,
+		and if so at which y it would rest. */
+	bool fits(size_t i, int w, int h, int& y) const {
+		int x = skyline[i].x;
+		if (x + w > width) {
+			return false;
+		}
+		y = skyline[i].y;
+		int remaining = w;
+		while (remaining > 0) {
+			if (i >= skyline.size()) {
+				return false;
+			}
+			if (skyline[i].y > y) {
+				y = skyline[i].y;
+			}
+			if (y + h > height) {
+				return false;
+			}
+			remaining -= skyline[i].width;
+			i++;
+		}
+		return true;
+	}
+
+	/** Raises the skyline over [x, x + w) to y, trimming the segments it covers */
+	void addSegment(int index, int x, int y, int w) {
+		Segment raised = { x, y, w };
+		skyline.insert(skyline.begin() + index, raised);
+
+		size_t i = index + 1;
+		while (i < skyline.size()) {
+			int overlap = raised.x + raised.width - skyline[i].x;
+			if (overlap <= 0) {
+				break;
+			}
+			if (overlap < skyline[i].width) {
+				skyline[i].x += overlap;
+				skyline[i].width -= overlap;
+				break;
+			}
+			skyline.erase(skyline.begin() + i);
+		}
+
+		// Merge neighbouring segments at the same height.
+		for (size_t j = 0; j + 1 < skyline.size(); ) {
+			if (skyline[j].y == skyline[j + 1].y) {
+				skyline[j].width += skyline[j + 1].width;
+				skyline.erase(skyline.begin() + j + 1);
+			} else {
+				j++;
+			}
+		}
+	}
+
+	/** The width of the area */
+	int width;
+	/** The height of the area */
+	int height;
+	/** Pixels covered by placed rectangles */
+	int usedArea = 0;
+	/** The top edge of the placed rectangles, from left to right */
+	std::vector<Segment> skyline;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <tuple>
+
+#include "SkylinePacker.h"
+
+/** A drawable image: a texture and the part of it holding the image */
+struct TextureRegion {
+	/** The texture containing the image */
+	SDL_Texture* texture;
+	/** Where the image lies within the texture */
+	SDL_Rect rect;
+};
+
+/** Packs small images into shared pages so draws using them share a texture */
+class TextureAtlas {
+public:
+	/** Gap left between packed images so filtering does not bleed between them */
+	static const int PADDING = 1;
+
+	/** Creates an atlas with no pages yet */
+	TextureAtlas(/** The width and height of each page */ int size = 2048) : pageSize(size) {}
+
+	/** Frees every page */
+	~TextureAtlas() {
+		clear();
+	}
+
+	/** Destroys all pages. Regions handed out before are no longer valid. */
+	void clear() {
+		for (auto it = pages.begin(); it != pages.end(); ++it) {
+			SDL_DestroyTexture(it->texture);
+		}
+		pages.clear();
+	}
+
+	/** Sets the size of pages created from now on */
+	void setPageSize(/** The width and height of each page */ int size) {
+		pageSize = size;
+	}
+
+	/** Sets the pixel format of pages created from now on. It should have alpha. */
+	void setFormat(/** An SDL pixel format */ Uint32 pixelFormat) {
+		format = pixelFormat;
+	}
+
+	/** Whether an image of the given size is small enough to be packed */
+	bool accepts(int w, int h) const {
+		return w <= pageSize / 4 && h <= pageSize / 4;
+	}
+
+	/** Copies the surface into the first page with room, creating a new page if none has.
+		Returns false if the image can't be packed. */
+	bool insert(/** The image to pack */ SDL_Surface* surface,
+		/** The renderer the pages belong to */ SDL_Renderer* ren,
+		/** Receives the page and the image's place in it */ TextureRegion& region) {
+		if (!accepts(surface->w, surface->h)) {
+			return false;
+		}
+
+		// Also turns any color key into transparent pixels.
+		SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+		if (converted == NULL) {
+			SDL_Log("Failed to convert surface for the texture atlas");
+			return false;
+		}
+
+		SDL_Point position;
+		Page* page = NULL;
+		for (auto it = pages.begin(); it != pages.end(); ++it) {
+			if (it->format == format && it->packer.insert(converted->w + PADDING, converted->h + PADDING, position)) {
+				page = &*it;
+				break;
+			}
+		}
+		if (page == NULL) {
+			page = addPage(ren);
+			if (page == NULL || !page->packer.insert(converted->w + PADDING, converted->h + PADDING, position)) {
+				SDL_FreeSurface(converted);
+				return false;
+			}
+		}
+
+		SDL_Rect rect = { position.x, position.y, converted->w, converted->h };
+		SDL_UpdateTexture(page->texture, &rect, converted->pixels, converted->pitch);
+		page->images++;
+		SDL_FreeSurface(converted);
+
+		region.texture = page->texture;
+		region.rect = rect;
+		return true;
+	}
+
+	/** Returns (images, used pixels, total pixels, fill ratio) for every page */
+	std::vector<std::tuple<int, int, int, float>> getStats() const {
+		std::vector<std::tuple<int, int, int, float>> stats;
+		for (auto it = pages.begin(); it != pages.end(); ++it) {
+			int used = it->packer.getUsedArea();
+			int total = it->packer.getTotalArea();
+			stats.push_back(std::make_tuple(it->images, used, total, (float) used / total));
+		}
+		return stats;
+	}
+
+private:
+	/** One texture shared by many images */
+	struct Page {
+		SDL_Texture* texture;
+		SkylinePacker packer;
+		int images;
+		Uint32 format;
+	};
+
+	/** Creates a new, fully transparent page */
+	Page* addPage(SDL_Renderer* ren) {
+		SDL_Texture* texture = SDL_CreateTexture(ren, format,
+			SDL_TEXTUREACCESS_STATIC, pageSize, pageSize);
+		if (texture == NULL) {
+			SDL_Log("Failed to create texture atlas page");
+			return NULL;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+		int pitch = pageSize * SDL_BYTESPERPIXEL(format);
+		std::vector<Uint8> blank((size_t) pitch * pageSize, 0);
+		SDL_UpdateTexture(texture, NULL, blank.data(), pitch);
+
+		Page page = { texture, SkylinePacker(pageSize, pageSize), 0, format };
+		pages.push_back(page);
+		SDL_Log("Allocated texture atlas page %d", (int) pages.size());
+		return &pages.back();
+	}
+
+	/** The width and height of new pages */
+	int pageSize;
+	/** The pixel format of new pages */
+	Uint32 format = SDL_PIXELFORMAT_RGBA32;
+	/** Every page created so far */
+	std::vector<Page> pages;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** A fixed set of worker threads running queued jobs in the order they were added */
+class ThreadPool {
+public:
+	/** Starts the given number of workers */
+	ThreadPool(/** How many threads to run jobs on */ int threads) {
+		for (int i = 0; i < threads; i++) {
+			workers.push_back(std::thread(&ThreadPool::work, this));
+		}
+	}
+
+	/** Finishes every queued job, then stops the workers */
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); i++) {
+			workers[i].join();
+		}
+	}
+
+	/** Queues a job to run on the next free worker */
+	void submit(/** The job */ std::function<void()> job) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.push_back(std::move(job));
+		}
+		wake.notify_one();
+	}
+
+	/** Returns a sensible number of workers for this machine, leaving a core for the game */
+	static int defaultSize() {
+		int cores = (int) std::thread::hardware_concurrency();
+		return cores > 2 ? cores - 1 : 1;
+	}
+
+private:
+	/** Runs jobs until the pool is stopped and the queue is empty */
+	void work() {
+		while (true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+				if (jobs.empty()) {
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	/** The worker threads */
+	std::vector<std::thread> workers;
+	/** Jobs waiting for a worker */
+	std::deque<std::function<void()>> jobs;
+	/** Guards jobs and stopping */
+	std::mutex mutex;
+	/** Signals workers when there is a job or the pool is stopping */
+	std::condition_variable wake;
+	/** Set when the pool is being destroyed */
+	bool stopping = false;
+};
+
+#endif
@@ -3,27 +3,47 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <vector>
 
 #include "ResourceManager.h"
+#include "GlyphAtlas.h"
 
 /** A manager for UI Rendering */
 class UIManager {
 public:
-	/** Gets the instance of the SFXManager */
+	/** Gets the instance of the UIManager. Safe to call from any thread, though text
+		must still be drawn from the thread that owns the renderer. */
 	static UIManager& instance() {
-		if (uiInstance == nullptr) {
-			uiInstance = new UIManager();
-			// if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
-			// {
-			// 	SDL_Log("Error opening mixer in SFXManager");
-			// }
-		}
-		return *uiInstance;
+		UIManager* inst = uiInstance.load(std::memory_order_acquire);
+		if (inst == nullptr) {
+			std::lock_guard<std::mutex> lock(instanceMutex);
+			inst = uiInstance.load(std::memory_order_relaxed);
+			if (inst == nullptr) {
+				inst = new UIManager();
+				uiInstance.store(inst, std::memory_order_release);
+			}
+		}
+		return *inst;
 	}
 
+	/** Renders text with its upper left corner at (x, y) */
 	void renderText(SDL_Renderer* gRenderer, std::string text,
-		std::string fontStyle, int fontSize,
+		const std::string& fontStyle, int fontSize,
 		SDL_Color color, int x, int y) {
+		if (glyphCacheEnabled) {
+			GlyphAtlas* atlas = getGlyphAtlas(fontStyle, fontSize);
+			if (atlas != NULL) {
+				drawText(gRenderer, atlas, text, color, x, y);
+			}
+			return;
+		}
 
 		TTF_Font* font = ResourceManager::instance().getFont(fontStyle, fontSize);
 		SDL_Surface* text_surface = TTF_RenderText_Solid(font, text.c_str(), color);
@@ -41,9 +61,28 @@ public:
 		SDL_DestroyTexture(texture);
 	}
 
+	/** Draws text from a glyph atlas with its upper left corner at (x, y) */
+	void drawText(SDL_Renderer* gRenderer, /** The font's glyphs */ GlyphAtlas* atlas,
+		const std::string& text, SDL_Color color, int x, int y) {
+		quads.clear();
+		atlas->layout(text, x, y, quads);
+		drawQuads(gRenderer, atlas, color);
+	}
+
+	/** Renders text horizontally centered on the screen */
 	void renderCenteredText(SDL_Renderer* gRenderer, std::string text,
-		std::string fontStyle, int fontSize,
+		const std::string& fontStyle, int fontSize,
 		SDL_Color color, int y, int screenWidth) {
+		if (glyphCacheEnabled) {
+			GlyphAtlas* atlas = getGlyphAtlas(fontStyle, fontSize);
+			if (atlas != NULL) {
+				int x = (screenWidth - atlas->measure(text)) / 2;
+				quads.clear();
+				atlas->layout(text, x, y, quads);
+				drawQuads(gRenderer, atlas, color);
+			}
+			return;
+		}
 
 		TTF_Font* font = ResourceManager::instance().getFont(fontStyle, fontSize);
 		SDL_Surface* text_surface = TTF_RenderText_Solid(font, text.c_str(), color);
@@ -63,14 +102,188 @@ public:
 		SDL_DestroyTexture(texture);
 	}
 
+	/** Chooses between drawing text from cached glyph atlases (the default)
+		and rendering a new surface and texture for every call. */
+	void setGlyphCacheEnabled(/** Whether to use glyph atlases */ bool enabled) {
+		glyphCacheEnabled = enabled;
+	}
+
+	/** Whether text is drawn from glyph atlases */
+	bool isGlyphCacheEnabled() const {
+		return glyphCacheEnabled;
+	}
+
+	/** Returns the glyph atlas for the given font and size, creating it on first use.
+		Atlases live as long as the UIManager, so each thread remembers the ones it has
+		looked up and finds them again without taking any lock. */
+	GlyphAtlas* getGlyphAtlas(/** The font path */ const std::string& fontStyle, /** The font size */ int fontSize) {
+		AtlasCache& cache = threadAtlases();
+		auto cached = cache.find(std::tie(fontStyle, fontSize));
+		if (cached != cache.end()) {
+			return cached->second;
+		}
+		GlyphAtlas* atlas = findGlyphAtlas(fontStyle, fontSize);
+		if (atlas != NULL) {
+			cache.insert(std::make_pair(std::make_tuple(fontStyle, fontSize), atlas));
+		}
+		return atlas;
+	}
+
+	/** Moves the glyph atlas of a font over to a reloaded copy of it, which it
+		rasterizes its glyphs from again */
+	void replaceFont(/** The font being closed */ TTF_Font* old, /** The font replacing it */ TTF_Font* font) {
+		std::unique_lock<std::shared_timed_mutex> lock(atlasMutex);
+		auto found = fontAtlases.find(old);
+		if (found == fontAtlases.end()) {
+			return;
+		}
+		GlyphAtlas* atlas = found->second;
+		fontAtlases.erase(found);
+		atlas->setFont(font);
+		fontAtlases.insert(std::make_pair(font, atlas));
+	}
+
+	/** Returns the bytes held by the glyph atlases of every size of the given font */
+	size_t getGlyphAtlasMemoryUsage(/** The font path */ std::string fontStyle) {
+		size_t bytes = 0;
+		std::shared_lock<std::shared_timed_mutex> lock(atlasMutex);
+		for (auto it = atlases.lower_bound(std::make_pair(fontStyle, 0));
+			it != atlases.end() && it->first.first == fontStyle; ++it) {
+			bytes += it->second->getMemoryUsage();
+		}
+		return bytes;
+	}
+
 private:
 	/** The Private constructor for the SFXManager */
 	UIManager() {}
 	/** The Private destructor for the SFXManager */
-	~UIManager() {}
+	~UIManager() {
+		for (auto it = fontAtlases.begin(); it != fontAtlases.end(); ++it) {
+			delete it->second;
+		}
+	}
+
+	/** A thread's atlases by font path and size, looked up with std::tie views so
+		finding one doesn't copy the path */
+	typedef std::map<std::tuple<std::string, int>, GlyphAtlas*, std::less<>> AtlasCache;
+
+	/** Returns the calling thread's atlases */
+	AtlasCache& threadAtlases() {
+		// A plain pointer, so nothing runs when a thread exits; the instance frees the caches.
+		static thread_local AtlasCache* cache = NULL;
+		if (cache == NULL) {
+			std::unique_ptr<AtlasCache> created(new AtlasCache());
+			cache = created.get();
+			std::lock_guard<std::mutex> lock(threadCachesMutex);
+			threadCaches.push_back(std::move(created));
+		}
+		return *cache;
+	}
+
+	/** getGlyphAtlas, for lookups the calling thread hasn't made before */
+	GlyphAtlas* findGlyphAtlas(const std::string& fontStyle, int fontSize) {
+		std::pair<std::string, int> key(fontStyle, fontSize);
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(atlasMutex);
+			auto found = atlases.find(key);
+			if (found != atlases.end()) {
+				return found->second;
+			}
+		}
+
+		// Loaded without atlasMutex held, since reloading a font takes the locks the other way around.
+		TTF_Font* font = ResourceManager::instance().getFont(fontStyle, fontSize);
+		if (font == NULL) {
+			return NULL;
+		}
+		std::unique_lock<std::shared_timed_mutex> lock(atlasMutex);
+		auto found = atlases.find(key);
+		if (found != atlases.end()) {
+			return found->second;
+		}
+		// Copies of a font file at different paths share one font, and so one atlas.
+		auto shared = fontAtlases.find(font);
+		if (shared != fontAtlases.end()) {
+			atlases.insert(std::make_pair(key, shared->second));
+			return shared->second;
+		}
+		GlyphAtlas* atlas = new GlyphAtlas(font);
+		atlases.insert(std::make_pair(key, atlas));
+		fontAtlases.insert(std::make_pair(font, atlas));
+		lock.unlock();
+		// The atlas rasterizes from the font for as long as it lives.
+		ResourceManager::instance().pin(fontStyle);
+		return atlas;
+	}
+
+
+	/** Draws the laid out quads from the atlas in one SDL_RenderGeometry call, tinted with
+		color. SDL versions before 2.0.18 lack it, so there each glyph is copied on its own. */
+	void drawQuads(SDL_Renderer* gRenderer, GlyphAtlas* atlas, SDL_Color color) {
+		if (quads.empty()) {
+			return;
+		}
+		SDL_Texture* texture = atlas->getTexture(gRenderer);
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+		SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+		SDL_SetTextureAlphaMod(texture, color.a);
+		for (size_t i = 0; i < quads.size(); i++) {
+			SDL_RenderCopy(gRenderer, texture, &quads[i].src, &quads[i].dst);
+		}
+#else
+		float size = (float) atlas->getSurface()->w;
+
+		int count = (int) quads.size();
+		while ((int) indices.size() < count * 6) {
+			int base = (int) indices.size() / 6 * 4;
+			int quad[6] = { base, base + 1, base + 2, base + 2, base + 3, base };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+
+		vertices.resize(count * 4);
+		for (int i = 0; i < count; i++) {
+			const SDL_Rect& src = quads[i].src;
+			const SDL_Rect& dst = quads[i].dst;
+			float u0 = src.x / size, v0 = src.y / size;
+			float u1 = (src.x + src.w) / size, v1 = (src.y + src.h) / size;
+			float x0 = (float) dst.x, y0 = (float) dst.y;
+			float x1 = (float) (dst.x + dst.w), y1 = (float) (dst.y + dst.h);
+
+			SDL_Vertex* v = &vertices[i * 4];
+			v[0] = { { x0, y0 }, color, { u0, v0 } };
+			v[1] = { { x1, y0 }, color, { u1, v0 } };
+			v[2] = { { x1, y1 }, color, { u1, v1 } };
+			v[3] = { { x0, y1 }, color, { u0, v1 } };
+		}
+
+		SDL_RenderGeometry(gRenderer, texture, vertices.data(), count * 4, indices.data(), count * 6);
+#endif
+	}
+
+	/** The current instance of the UIManager */
+	static std::atomic<UIManager*> uiInstance;
+	/** Guards creating the instance */
+	static std::mutex instanceMutex;
+	/** Guards atlases and fontAtlases */
+	std::shared_timed_mutex atlasMutex;
 
-	/** The current instance of the SFXManager */
-	static UIManager* uiInstance;
+	/** Whether text is drawn from glyph atlases */
+	bool glyphCacheEnabled = true;
+	/** Glyph atlases by font path and size */
+	std::map<std::pair<std::string, int>, GlyphAtlas*> atlases;
+	/** Guards threadCaches */
+	std::mutex threadCachesMutex;
+	/** Every thread's atlases */
+	std::vector<std::unique_ptr<AtlasCache>> threadCaches;
+	/** The glyph atlas of each font, which owns them */
+	std::map<TTF_Font*, GlyphAtlas*> fontAtlases;
+	/** Scratch quads for the text being drawn */
+	std::vector<GlyphQuad> quads;
+	/** Scratch vertices for the text being drawn */
+	std::vector<SDL_Vertex> vertices;
+	/** Quad indices, which only ever grow */
+	std::vector<int> indices;
 };
 
 #endif
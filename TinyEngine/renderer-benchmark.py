@@ -0,0 +1,58 @@
+# Compares drawing throughput of the SDL_Renderer and OpenGL backends.
+#
+# Run with: python3 renderer-benchmark.py
+#
+# Each backend runs in its own process, since a window's backend is chosen
+# when the engine is constructed. To run without a GPU or display under
+# Mesa's llvmpipe, use:
+#
+#   SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 python3 renderer-benchmark.py
+
+import subprocess
+import sys
+import time
+
+SCREEN_WIDTH = 640
+SCREEN_HEIGHT = 480
+SPRITES = 5000
+RECTANGLES = 2000
+LINES = 2000
+FRAMES = 200
+
+def run(backend):
+    import tinyengine
+    import random
+
+    engine = tinyengine.GameEngine(SCREEN_WIDTH, SCREEN_HEIGHT, "Renderer Benchmark", backend)
+    engine.SetBackgroundColor(0, 0, 0, 255)
+    engine.SetTextColor(255, 255, 255, 255)
+
+    random.seed(1)
+    sprites = [(random.randrange(SCREEN_WIDTH), random.randrange(SCREEN_HEIGHT), 16, 16) for i in range(SPRITES)]
+    rects = [(random.randrange(SCREEN_WIDTH), random.randrange(SCREEN_HEIGHT), 8, 8) for i in range(RECTANGLES)]
+    lines = [((random.randrange(SCREEN_WIDTH), random.randrange(SCREEN_HEIGHT)),
+              (random.randrange(SCREEN_WIDTH), random.randrange(SCREEN_HEIGHT))) for i in range(LINES)]
+
+    start = time.perf_counter()
+    for frame in range(FRAMES):
+        engine.clear()
+        engine.DrawImageBatch("resources/space-invaders/space-invader.png", sprites)
+        engine.SetColor(255, 255, 255, 255)
+        for r in rects:
+            engine.DrawRectangle(r[0], r[1], r[2], r[3], True)
+        engine.SetColor(0, 204, 102, 255)
+        for a, b in lines:
+            engine.DrawLine(a, b)
+        engine.RenderText("frame " + str(frame), "resources/arial.ttf", 16, 10, 10)
+        engine.flip()
+    elapsed = time.perf_counter() - start
+
+    print("{}: {:.2f} ms/frame, {:.0f} fps, {} draw calls/frame".format(
+        backend, elapsed * 1000 / FRAMES, FRAMES / elapsed, engine.GetDrawCallsSubmitted()))
+
+if len(sys.argv) > 1:
+    run(sys.argv[1])
+else:
+    print("{} sprites, {} rectangles, {} lines per frame".format(SPRITES, RECTANGLES, LINES))
+    for backend in ["sdl", "gl"]:
+        subprocess.call([sys.executable, sys.argv[0], backend])
@@ -160,10 +160,9 @@ while not engine.pressed("q") and not hitBottom and not won:
             for y in range(0, h):
                 hitBottom = enemyMatrix[y][x].moveDownRow(16)
 
-    #draw enemies
-    for x in range(0, w):
-        for y in range(0, h):
-            enemyMatrix[y][x].draw()
+    #draw enemies, all in one batch since they share an image
+    engine.DrawImageBatch("resources/space-invaders/space-invader.png",
+        [(e.x, e.y, e.w, e.h) for row in enemyMatrix for e in row if e.enabled])
 
     #handle player input
     if engine.pressed("left"):
@@ -0,0 +1,43 @@
+# Measures what animated sprites cost per call, using the braid sprite sheet
+# from the hello-world demo. DrawFrame used to decode the whole 1024x1024 sheet
+# on every call just to read its width; it now looks up a frame table built
+# when the sheet is first loaded, so it should cost about as much as DrawImage.
+#
+# Run with: python3 sprite-benchmark.py
+
+import tinyengine
+import time
+
+SCREEN_WIDTH = 500
+SCREEN_HEIGHT = 500
+SPRITES = 200
+FRAMES = 120
+SHEET = "resources/hello-world/braid.png"
+
+engine = tinyengine.GameEngine(SCREEN_WIDTH, SCREEN_HEIGHT, "Sprite Benchmark")
+engine.SetBackgroundColor(255, 255, 255, 255)
+engine.SetFramerate(60)
+
+def run(animated):
+    start = time.perf_counter()
+    for frame in range(FRAMES):
+        engine.clear()
+        for i in range(SPRITES):
+            x = (i % 20) * 20
+            y = (i // 20) * 40
+            if animated:
+                engine.DrawFrame(SHEET, frame % 60, 27, x, y, 130, 150)
+            else:
+                engine.DrawImage(SHEET, x, y, 130, 150)
+        engine.flip()
+    return (time.perf_counter() - start) * 1000000 / (FRAMES * SPRITES)
+
+# Load the sheet before timing.
+run(True)
+
+still = run(False)
+animated = run(True)
+
+print("{} sprites per frame".format(SPRITES))
+print("DrawImage: {:.2f} us/call".format(still))
+print("DrawFrame: {:.2f} us/call".format(animated))
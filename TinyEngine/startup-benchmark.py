@@ -0,0 +1,51 @@
+# Compares how long each demo's resources take to load from loose files and
+# from an asset pack made by cook-assets.py.
+#
+# Run with: python3 cook-assets.py && python3 startup-benchmark.py
+#
+# Every measurement runs in a fresh process, so nothing is cached by the engine.
+# The operating system still caches the files themselves after the first run;
+# for truly cold numbers, drop the file cache before each run.
+
+import os
+import subprocess
+import sys
+import time
+
+PACK = "resources.pack"
+DEMOS = ["asteroids", "hello-world", "space-invaders", "space-race"]
+RUNS = 5
+
+def load(demo, packed):
+    import tinyengine
+
+    start = time.perf_counter()
+    engine = tinyengine.GameEngine(640, 480, "Startup Benchmark", headless=True)
+    if packed:
+        engine.LoadAssetPack(PACK)
+    directory = "resources/" + demo
+    for name in sorted(os.listdir(directory)):
+        path = directory + "/" + name
+        if name.endswith(".png"):
+            engine.LoadTexture(path)
+        elif name.endswith(".wav") or name.endswith(".mp3"):
+            engine.LoadSound(path)
+        elif name.endswith(".ttf"):
+            engine.LoadFont(path, 12)
+    return (time.perf_counter() - start) * 1000
+
+def measure(demo, packed):
+    times = []
+    for i in range(RUNS):
+        output = subprocess.check_output([sys.executable, __file__, demo, "packed" if packed else "loose"])
+        times.append(float(output.decode().split()[-1]))
+    return min(times)
+
+if len(sys.argv) > 2:
+    print(load(sys.argv[1], sys.argv[2] == "packed"))
+else:
+    if not os.path.exists(PACK):
+        sys.exit("Run cook-assets.py first")
+    print("{:16} {:>10} {:>10}".format("demo", "loose", "packed"))
+    for demo in DEMOS:
+        print("{:16} {:8.1f}ms {:8.1f}ms".format(demo, measure(demo, False), measure(demo, True)))
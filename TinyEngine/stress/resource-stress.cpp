@@ -0,0 +1,255 @@
+// Looks resources, glyph atlases and the managers themselves up from several threads
+// at once while the main thread loads, evicts and reloads others, to shake out races
+// in the ResourceManager's, SFXManager's and UIManager's caches.
+//
+// Build it with ThreadSanitizer and run it from this directory:
+//
+//   g++ -std=c++14 -O1 -g -fsanitize=thread -I../include resource-stress.cpp ../AssetPack.cpp ../FileWatcher.cpp ../ResourceManager.cpp ../SFXManager.cpp ../UIManager.cpp -o resource-stress -lSDL2 -lSDL2_image -lSDL2_mixer -lSDL2_ttf -pthread
+//   SDL_AUDIODRIVER=dummy ./resource-stress [seconds] [threads] [font]
+//
+// font defaults to ../resources/arial.ttf.
+//
+// Any ThreadSanitizer report, or any line starting with FAIL, is a bug. It writes its
+// images and sounds to the current directory and removes them when it finishes.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResourceManager.h"
+#include "SFXManager.h"
+#include "UIManager.h"
+
+// Images every thread looks up. They are pinned, so only the main thread ever loads them.
+static const int SHARED = 12;
+// Images the main thread keeps loading, each evicting the last.
+static const int CHURN = 12;
+// Sounds every thread looks up, loading them on first use.
+static const int SOUNDS = 6;
+// Frame size for the sprite sheet lookups.
+static const int FRAME = 8;
+// Font sizes every thread looks glyph atlases up for.
+static const int FONT_SIZES = 4;
+
+static std::string path(const char* kind, int i, const char* extension) {
+    return std::string("stress-") + kind + "-" + std::to_string(i) + extension;
+}
+
+// Writes a w by h image in one shade with a pure green top row, so it has a color key.
+static bool writeImage(const std::string& file, int w, int h, Uint8 shade) {
+    SDL_Surface* image = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (image == NULL) {
+        return false;
+    }
+    SDL_FillRect(image, NULL, SDL_MapRGB(image->format, shade, shade, shade));
+    SDL_Rect top = { 0, 0, w, 1 };
+    SDL_FillRect(image, &top, SDL_MapRGB(image->format, 0, 255, 0));
+    bool saved = SDL_SaveBMP(image, file.c_str()) == 0;
+    SDL_FreeSurface(image);
+    return saved;
+}
+
+// Writes a WAV file of the given number of silent 16 bit mono samples.
+static bool writeSound(const std::string& file, Uint32 samples) {
+    SDL_RWops* out = SDL_RWFromFile(file.c_str(), "wb");
+    if (out == NULL) {
+        return false;
+    }
+    Uint32 bytes = samples * 2;
+    bool ok = SDL_RWwrite(out, "RIFF", 4, 1) == 1 && SDL_WriteLE32(out, 36 + bytes) == 1
+        && SDL_RWwrite(out, "WAVEfmt ", 8, 1) == 1 && SDL_WriteLE32(out, 16) == 1
+        && SDL_WriteLE16(out, 1) == 1 && SDL_WriteLE16(out, 1) == 1
+        && SDL_WriteLE32(out, 22050) == 1 && SDL_WriteLE32(out, 22050 * 2) == 1
+        && SDL_WriteLE16(out, 2) == 1 && SDL_WriteLE16(out, 16) == 1
+        && SDL_RWwrite(out, "data", 4, 1) == 1 && SDL_WriteLE32(out, bytes) == 1;
+    for (Uint32 i = 0; i < samples && ok; i++) {
+        ok = SDL_WriteLE16(out, 0) == 1;
+    }
+    return SDL_RWclose(out) == 0 && ok;
+}
+
+static int sharedWidth(int i) {
+    return 64 + 8 * i;
+}
+
+// Records the first answer to a lookup that must always give the same one, and
+// returns whether answer is that one.
+template <typename T>
+static bool sameAsFirst(std::atomic<T*>& first, T* answer) {
+    T* expected = NULL;
+    return answer != NULL && (first.compare_exchange_strong(expected, answer) || expected == answer);
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+    int threads = argc > 2 ? atoi(argv[2]) : (int) std::max(2u, std::thread::hardware_concurrency());
+    std::string font = argc > 3 ? argv[3] : "../resources/arial.ttf";
+
+    if (SDL_Init(SDL_INIT_AUDIO) != 0 || Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 1024) != 0) {
+        printf("FAIL: could not open audio: %s\n", SDL_GetError());
+        return 1;
+    }
+    IMG_Init(IMG_INIT_PNG);
+    TTF_Init();
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* ren = target != NULL ? SDL_CreateSoftwareRenderer(target) : NULL;
+    if (ren == NULL) {
+        printf("FAIL: could not create a renderer: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    std::vector<std::string> shared, churn, sounds, files;
+    for (int i = 0; i < SHARED; i++) {
+        shared.push_back(path("shared", i, ".bmp"));
+        writeImage(shared.back(), sharedWidth(i), 64, (Uint8) (i * 16));
+    }
+    // The same contents as the first shared image, so it is looked up as an alias.
+    shared.push_back(path("alias", 0, ".bmp"));
+    writeImage(shared.back(), sharedWidth(0), 64, 0);
+    for (int i = 0; i < CHURN; i++) {
+        churn.push_back(path("temp", i, ".bmp"));
+        writeImage(churn.back(), 128, 128, (Uint8) (255 - i * 16));
+    }
+    for (int i = 0; i < SOUNDS; i++) {
+        sounds.push_back(path("sound", i, ".wav"));
+        writeSound(sounds.back(), 2048 + 512 * i);
+    }
+    files.insert(files.end(), shared.begin(), shared.end());
+    files.insert(files.end(), churn.begin(), churn.end());
+    files.insert(files.end(), sounds.begin(), sounds.end());
+
+    // Textures belong to the main thread, so every image the other threads ask for is
+    // loaded here first and pinned. A tiny budget makes every other load evict.
+    ResourceManager& resources = ResourceManager::instance();
+    resources.setCacheBudget("textures", 1);
+    for (size_t i = 0; i < shared.size(); i++) {
+        resources.pin(shared[i]);
+        if (resources.getTextureRegion(shared[i], ren).texture == NULL) {
+            printf("FAIL: could not load %s\n", shared[i].c_str());
+            return 1;
+        }
+    }
+    if (resources.getFont(font, 12) == NULL) {
+        printf("FAIL: could not load %s\n", font.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<long long> lookups(0);
+    std::atomic<int> failures(0);
+    // The first answer any thread got for each lookup that must always give the same one.
+    std::atomic<SFXManager*> sfxManager(NULL);
+    std::atomic<GlyphAtlas*> atlases[FONT_SIZES];
+    for (int i = 0; i < FONT_SIZES; i++) {
+        atlases[i] = NULL;
+    }
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            unsigned int seed = (unsigned int) t * 7919 + 1;
+            long long done = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                seed = seed * 1103515245 + 12345;
+                int i = (int) ((seed >> 8) % shared.size());
+                const std::string& image = shared[i];
+                int w = sharedWidth(i == SHARED ? 0 : i);
+
+                bool ok = resources.getTexture(image, ren) != NULL
+                    && resources.getTextureRegion(image, ren).texture != NULL;
+                SDL_Point size = resources.getIMGDimensions(image);
+                ok = ok && size.x == w && size.y == 64;
+                const std::vector<SDL_Rect>& frames = resources.getFrameRects(image, FRAME, FRAME);
+                ok = ok && (int) frames.size() == (w / FRAME) * (64 / FRAME);
+                int level = 1;
+                ok = ok && resources.getMip(image, level) != NULL && level == 1;
+                if ((seed >> 4) % 16 == 0) {
+                    ok = ok && resources.getSFX(sounds[(seed >> 12) % SOUNDS]) != NULL;
+                }
+                if (!ok && failures.fetch_add(1) < 10) {
+                    printf("FAIL: thread %d got a wrong answer for %s\n", t, image.c_str());
+                }
+                done += 6;
+
+                // The other managers, which the first few lookups also create.
+                int fontSize = (int) ((seed >> 16) % FONT_SIZES);
+                ok = sameAsFirst(sfxManager, &SFXManager::instance())
+                    && sameAsFirst(atlases[fontSize], UIManager::instance().getGlyphAtlas(font, 12 + 4 * fontSize));
+                if ((seed >> 4) % 64 == 0) {
+                    SFXManager::instance().playSFX(sounds[(seed >> 12) % SOUNDS]);
+                }
+                if (!ok && failures.fetch_add(1) < 10) {
+                    printf("FAIL: thread %d got a wrong manager or glyph atlas\n", t);
+                }
+                done += 2;
+            }
+            lookups += done;
+        }));
+    }
+
+    // Meanwhile keep loading, evicting, reloading and pinning on the main thread.
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 end = start + (Uint64) (seconds * SDL_GetPerformanceFrequency());
+    auto imageReloaded = [](const std::string&, SDL_Surface*) {};
+    auto fontReplaced = [](TTF_Font* old, TTF_Font* replacement) {
+        UIManager::instance().replaceFont(old, replacement);
+    };
+    int rounds = 0;
+    for (; SDL_GetPerformanceCounter() < end; rounds++) {
+        // The texture just loaded must survive the evictions its own load causes.
+        const std::string& image = churn[rounds % CHURN];
+        int level = 1;
+        if ((resources.getTexture(image, ren) == NULL || resources.getMip(image, level) == NULL)
+            && failures.fetch_add(1) < 10) {
+            printf("FAIL: %s was evicted as it loaded\n", image.c_str());
+        }
+        if (rounds % 8 == 0) {
+            // Not the first image, which the alias shares.
+            resources.reload(shared[1 + rounds / 8 % (SHARED - 1)], imageReloaded, fontReplaced);
+        }
+        if (rounds % 32 == 4) {
+            // The glyph atlases move over to the new fonts while other threads look them up.
+            resources.reload(font, imageReloaded, fontReplaced);
+        }
+        if (rounds % 16 == 0) {
+            resources.pin(churn[0]);
+            resources.getCacheStats();
+            resources.unpin(churn[0]);
+        }
+    }
+    stop = true;
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    double elapsed = (double) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    printf("%d threads made %lld lookups in %.1f s (%.0f per second) over %d loads and %d reloads\n",
+        threads, lookups.load(), elapsed, lookups.load() / elapsed, rounds, rounds / 8 + 1);
+    std::vector<std::tuple<std::string, size_t, size_t, int, int, int, int>> stats = resources.getCacheStats();
+    for (size_t i = 0; i < stats.size(); i++) {
+        printf("%-8s %8zu bytes %4d entries %10d hits %6d misses %6d evictions\n", std::get<0>(stats[i]).c_str(),
+            std::get<1>(stats[i]), std::get<3>(stats[i]), std::get<4>(stats[i]), std::get<5>(stats[i]), std::get<6>(stats[i]));
+    }
+
+    ResourceManager::reset();
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(target);
+    Mix_CloseAudio();
+    IMG_Quit();
+    SDL_Quit();
+    for (size_t i = 0; i < files.size(); i++) {
+        remove(files[i].c_str());
+    }
+    if (failures > 0) {
+        printf("FAIL: %d wrong answers\n", failures.load());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+# Compares drawing text from the glyph cache against rendering a new
+# surface and texture for every label.
+#
+# Run with: python3 text-benchmark.py
+
+import tinyengine
+import time
+
+SCREEN_WIDTH = 800
+SCREEN_HEIGHT = 600
+LABELS = 1000
+FRAMES = 120
+FONT = "resources/arial.ttf"
+
+engine = tinyengine.GameEngine(SCREEN_WIDTH, SCREEN_HEIGHT, "Text Benchmark")
+engine.SetBackgroundColor(0, 0, 0, 255)
+engine.SetTextColor(255, 255, 255, 255)
+
+def run(cached):
+    engine.SetTextCaching(cached)
+    start = time.perf_counter()
+    for frame in range(FRAMES):
+        engine.clear()
+        for i in range(LABELS):
+            x = (i % 10) * 80
+            y = (i // 10) * 6
+            # The labels change every frame, like score counters do.
+            engine.RenderText("score: " + str(frame * LABELS + i), FONT, 12, x, y)
+        engine.flip()
+    return (time.perf_counter() - start) * 1000 / FRAMES
+
+# Warm up the font and the glyph cache before timing.
+run(True)
+
+uncached = run(False)
+cached = run(True)
+
+print("{} labels per frame".format(LABELS))
+print("per-call surfaces: {:.2f} ms/frame".format(uncached))
+print("glyph cache:       {:.2f} ms/frame".format(cached))
+print("speedup:           {:.1f}x".format(uncached / cached))